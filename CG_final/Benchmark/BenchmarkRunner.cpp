@@ -0,0 +1,216 @@
+#include "BenchmarkRunner.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+
+// read the flat objects of the results array ({ "key": "text" or number, ... })
+static std::vector<std::map<std::string, std::string>> parseObjects(const std::string& text)
+{
+	std::vector<std::map<std::string, std::string>> objects;
+	size_t i = text.find('[');
+	while (i != std::string::npos && (i = text.find_first_of("{]", i)) != std::string::npos && text[i] == '{')
+	{
+		std::map<std::string, std::string> object;
+		// i is at the opening brace or at the end of the last value
+		while ((i = text.find_first_of("\"}", i + 1)) != std::string::npos && text[i] == '"')
+		{
+			const size_t keyEnd = text.find('"', i + 1);
+			const size_t colon = text.find(':', keyEnd);
+			const size_t valueStart = text.find_first_not_of(" \t\r\n", colon + 1);
+			if (keyEnd == std::string::npos || colon == std::string::npos || valueStart == std::string::npos)
+				return objects;
+			const std::string key = text.substr(i + 1, keyEnd - i - 1);
+			if (text[valueStart] == '"')
+			{
+				i = text.find('"', valueStart + 1);
+				object[key] = text.substr(valueStart + 1, i - valueStart - 1);
+			}
+			else
+			{
+				// numbers end before the next separator
+				i = text.find_first_of(",}", valueStart);
+				object[key] = text.substr(valueStart, i - valueStart);
+				if (i == std::string::npos || text[i] == '}')
+					break;
+			}
+		}
+		objects.push_back(object);
+		if (i != std::string::npos)
+			i++;
+	}
+	return objects;
+}
+
+BenchmarkRunner::BenchmarkRunner(double minTime, int numBatches)
+	:minTime(minTime), numBatches(numBatches) {}
+
+void BenchmarkRunner::run(const std::string& name, int size, float density, size_t numElements,
+	const std::function<void()>& setup, const std::function<void()>& kernel)
+{
+	if (name.find(filter) == std::string::npos)
+		return;
+	using Clock = std::chrono::steady_clock;
+
+	// the first run only warms up caches and allocations
+	setup();
+	kernel();
+
+	double best = HUGE_VAL;
+	for (int batch = 0; batch < numBatches; batch++)
+	{
+		// the kernel is repeated until the batch is long enough for the clock, only kernel time is counted
+		double time = 0.0;
+		size_t elements = 0;
+		do
+		{
+			setup();
+			const Clock::time_point start = Clock::now();
+			kernel();
+			time += std::chrono::duration<double>(Clock::now() - start).count();
+			elements += numElements;
+		} while (time < minTime / numBatches);
+		// the best batch is the one least disturbed by the rest of the system
+		best = std::min(best, time * 1e9 / elements);
+	}
+
+	if (!kernelHeader)
+	{
+		std::printf("%-24s %8s %8s %12s %12s %10s\n", "kernel", "size", "density", "ns/element", "M/s", "baseline");
+		kernelHeader = true;
+	}
+	BenchmarkResult result;
+	result.name = name;
+	result.size = size;
+	result.density = density;
+	result.nsPerElement = best;
+	double change;
+	float allowed;
+	const bool regression = compare(result, change, allowed);
+	std::printf("%-24s %8d %8.2f %12.3f %12.1f", name.c_str(), size, density, best, 1e3 / best);
+	if (!std::isnan(change))
+		std::printf(" %+9.1f%%", 100.0 * change);
+	if (regression)
+		std::printf("  REGRESSION (more than %.0f%% slower)", 100.0f * allowed);
+	std::printf("\n");
+}
+
+void BenchmarkRunner::addScenario(const std::string& name, int ticks, float p50, float p95, float p99)
+{
+	if (!scenarioHeader)
+	{
+		std::printf("%-24s %8s %10s %10s %10s  %s\n", "scenario", "ticks", "p50 ms", "p95 ms", "p99 ms", "baseline p50/p95/p99");
+		scenarioHeader = true;
+	}
+	std::printf("%-24s %8d %10.3f %10.3f %10.3f ", name.c_str(), ticks, 1e3f * p50, 1e3f * p95, 1e3f * p99);
+	const char* suffixes[] = { "_tick_p50", "_tick_p95", "_tick_p99" };
+	const float times[] = { p50, p95, p99 };
+	bool regression = false;
+	for (int i = 0; i < 3; i++)
+	{
+		BenchmarkResult result;
+		result.name = name + suffixes[i];
+		result.size = ticks;
+		result.nsPerElement = 1e9 * times[i];
+		double change;
+		float allowed;
+		if (compare(result, change, allowed))
+			regression = true;
+		if (std::isnan(change))
+			std::printf(" %7s", "-");
+		else
+			std::printf(" %+6.1f%%", 100.0 * change);
+	}
+	std::printf("%s\n", regression ? "  REGRESSION" : "");
+}
+
+bool BenchmarkRunner::compare(BenchmarkResult& result, double& change, float& allowed)
+{
+	change = NAN;
+	allowed = threshold;
+	const BenchmarkResult* previous = findBaseline(result);
+	if (previous)
+	{
+		change = result.nsPerElement / previous->nsPerElement - 1.0;
+		if (previous->threshold >= 0.0f)
+			allowed = previous->threshold;
+		// thresholds of the baseline are kept when the results are saved
+		result.threshold = previous->threshold;
+	}
+	results.push_back(result);
+	if (!(change > allowed))
+		return false;
+	numRegressions++;
+	return true;
+}
+
+void BenchmarkRunner::setFilter(const std::string& filter)
+{
+	this->filter = filter;
+}
+
+void BenchmarkRunner::setThreshold(float threshold)
+{
+	this->threshold = threshold;
+}
+
+bool BenchmarkRunner::loadBaseline(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+	std::stringstream text;
+	text << file.rdbuf();
+	for (const std::map<std::string, std::string>& object : parseObjects(text.str()))
+	{
+		BenchmarkResult result;
+		auto get = [&](const char* key) { auto it = object.find(key); return it != object.end() ? it->second : std::string(); };
+		result.name = get("name");
+		result.size = std::atoi(get("size").c_str());
+		result.density = (float)std::atof(get("density").c_str());
+		result.nsPerElement = std::atof(get("ns_per_element").c_str());
+		if (!get("threshold").empty())
+			result.threshold = (float)std::atof(get("threshold").c_str());
+		if (!result.name.empty() && result.nsPerElement > 0.0)
+			baseline.push_back(result);
+	}
+	return true;
+}
+
+bool BenchmarkRunner::saveResults(const std::string& path)
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+	file << "{\n\t\"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		file << "\t\t{ \"name\": \"" << result.name << "\", \"size\": " << result.size << ", \"density\": " << result.density
+			<< ", \"ns_per_element\": " << result.nsPerElement;
+		if (result.threshold >= 0.0f)
+			file << ", \"threshold\": " << result.threshold;
+		file << " }" << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	file << "\t]\n}\n";
+	return true;
+}
+
+int BenchmarkRunner::getNumRegressions()
+{
+	return numRegressions;
+}
+
+const BenchmarkResult* BenchmarkRunner::findBaseline(const BenchmarkResult& result)
+{
+	for (const BenchmarkResult& previous : baseline)
+	{
+		if (previous.name == result.name && previous.size == result.size && std::abs(previous.density - result.density) < 1e-4f)
+			return &previous;
+	}
+	return nullptr;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+
+// time of one kernel over one data set
+struct BenchmarkResult
+{
+	std::string name;
+	int size = 0;
+	// depends on the kernel (e.g. particles per grid cell), 0 when it has none
+	float density = 0.0f;
+	// best time per element of all batches
+	double nsPerElement = 0.0;
+	// allowed relative slowdown before it counts as a regression (negative uses the default one)
+	float threshold = -1.0f;
+};
+
+// run kernels over synthetic data, print their time per element and compare them with a baseline
+// (scenarios are printed as a table of their own with tick times, see addScenario)
+class BenchmarkRunner
+{
+public:
+	// every result is the best of numBatches batches, minTime seconds are spent on all of them together
+	BenchmarkRunner(double minTime = 0.5, int numBatches = 5);
+
+	// setup prepares the data and isn't timed, kernel is timed and processes numElements elements
+	void run(const std::string& name, int size, float density, size_t numElements,
+		const std::function<void()>& setup, const std::function<void()>& kernel);
+
+	// print and keep the tick time percentiles (in seconds) of a scenario measured elsewhere, every percentile
+	// is stored and compared with the baseline like a kernel (<name>_tick_p50 with the ticks as size)
+	void addScenario(const std::string& name, int ticks, float p50, float p95, float p99);
+
+	// only kernels whose name contains filter are run
+	void setFilter(const std::string& filter);
+	// default allowed slowdown (0.1 means 10% slower than the baseline)
+	void setThreshold(float threshold);
+	// results of an earlier run in the format of saveResults
+	bool loadBaseline(const std::string& path);
+	// thresholds set in the baseline are kept, so it can be regenerated without losing them
+	bool saveResults(const std::string& path);
+	int getNumRegressions();
+
+private:
+	const BenchmarkResult* findBaseline(const BenchmarkResult& result);
+	// keep the result and compare it with the baseline, change is relative (NaN without baseline) and allowed is
+	// the threshold that applies, returns whether it is a regression
+	bool compare(BenchmarkResult& result, double& change, float& allowed);
+
+	double minTime;
+	int numBatches;
+	std::string filter;
+	float threshold = 0.1f;
+	std::vector<BenchmarkResult> baseline;
+	std::vector<BenchmarkResult> results;
+	int numRegressions = 0;
+	// tables are only printed once they get a row
+	bool kernelHeader = false;
+	bool scenarioHeader = false;
+};
@@ -0,0 +1,311 @@
+#include "Scenario.hpp"
+#include "Solver.hpp"
+#include "CollisionGrid.hpp"
+#include "Random.hpp"
+#include "Math.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+
+// smallest number of arguments of every action
+static const std::map<std::string, int> ACTION_ARGUMENTS = {
+	{ "particle", 2 }, { "cube", 2 }, { "circle", 4 }, { "fountain", 3 }, { "bridge", 4 }, { "wind", 0 }, { "force", 3 }
+};
+
+// kinetic and potential energy of the moving particles (the floor is at the bottom of the world)
+static double getEnergy(Solver& solver)
+{
+	const float height = solver.getWorld().y;
+	const float gravity = solver.getGravity().y;
+	const float stepDt = solver.getStepDt();
+	double energy = 0.0;
+	for (const Particle& particle : solver.getParticles().getData())
+	{
+		const float inverseMass = solver.getInverseMass(particle);
+		if (particle.pinned || inverseMass == 0.0f)
+			continue;
+		const sf::Vector2f velocity = (particle.currentPosition - particle.prevPosition) / stepDt;
+		// y grows downward
+		energy += (0.5f * (velocity.x * velocity.x + velocity.y * velocity.y) + gravity * (height - particle.currentPosition.y)) / inverseMass;
+	}
+	return energy;
+}
+
+bool Scenario::load(const std::string& path, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "can't read " + path;
+		return false;
+	}
+	// the name is the file name without directory and extension unless it is set
+	name = path.substr(path.find_last_of("/\\") + 1);
+	name = name.substr(0, name.find('.'));
+	winds.clear();
+	events.clear();
+
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(file, text))
+	{
+		lineNumber++;
+		std::istringstream line(text.substr(0, text.find('#')));
+		std::string keyword;
+		if (!(line >> keyword))
+			continue;
+		const std::string where = path + ":" + std::to_string(lineNumber) + ": ";
+
+		bool valid = true;
+		if (keyword == "name")
+			valid = (bool)(line >> name);
+		else if (keyword == "seed")
+			valid = (bool)(line >> seed);
+		else if (keyword == "world")
+			valid = (bool)(line >> worldSize.x >> worldSize.y);
+		else if (keyword == "radius")
+			valid = (bool)(line >> radius);
+		else if (keyword == "framerate")
+			valid = (bool)(line >> framerate);
+		else if (keyword == "sub_steps")
+			valid = (bool)(line >> subSteps);
+		else if (keyword == "collision_iterations")
+			valid = (bool)(line >> collisionIterations);
+		else if (keyword == "constraint_iterations")
+			valid = (bool)(line >> constraintIterations);
+		else if (keyword == "ticks")
+			valid = (bool)(line >> ticks);
+		else if (keyword == "max_particles")
+			valid = (bool)(line >> maxParticles);
+		else if (keyword == "wind_area")
+		{
+			std::vector<float> wind(6);
+			for (float& value : wind)
+				valid = valid && (line >> value);
+			winds.push_back(wind);
+		}
+		else if (keyword == "at" || keyword == "every")
+		{
+			ScenarioEvent event;
+			event.line = lineNumber;
+			std::string action;
+			if (keyword == "at")
+			{
+				valid = (bool)(line >> event.start >> action);
+			}
+			else
+			{
+				valid = (bool)(line >> event.interval >> action) && event.interval > 0;
+				// the range is optional and comes before the action
+				while (valid && (action == "from" || action == "until"))
+				{
+					int tick;
+					valid = (bool)(line >> tick);
+					if (action == "from")
+						event.start = tick;
+					else
+						event.end = tick;
+					valid = valid && (line >> action);
+				}
+			}
+			if (valid && !parseAction(event, action, line, error))
+			{
+				error = where + error;
+				return false;
+			}
+		}
+		else
+		{
+			error = where + "unknown setting " + keyword;
+			return false;
+		}
+
+		if (!valid)
+		{
+			error = where + "invalid arguments of " + keyword;
+			return false;
+		}
+	}
+	return true;
+}
+
+ScenarioResult Scenario::run()
+{
+	Solver solver(worldSize, radius, (int)(2 * radius));
+	solver.setFrameDt(framerate);
+	solver.setSubSteps(subSteps);
+	solver.setCollisionIterations(collisionIterations);
+	solver.setConstraintIterations(constraintIterations);
+	for (const std::vector<float>& wind : winds)
+		solver.addWind({ wind[0], wind[1] }, { wind[2], wind[3] }, wind[4], wind[5]);
+	RNG rng;
+	rng.generator.seed(seed);
+
+	// actions go through the same commands as the input of the game (except bridges, which main builds directly too)
+	// returns false if nothing was done (spawning when the limit is reached)
+	auto apply = [&](const ScenarioEvent& event, int tick)
+	{
+		const std::vector<float>& a = event.arguments;
+		const bool spawning = event.action == "particle" || event.action == "cube" || event.action == "circle" || event.action == "fountain";
+		if (spawning && solver.getNumParticles() >= maxParticles)
+			return false;
+		if (event.action == "particle")
+		{
+			const sf::Vector2f velocity = a.size() >= 4 ? sf::Vector2f(a[2], a[3]) : sf::Vector2f(0.0f, 0.0f);
+			solver.pushCommand(Command::spawnParticle({ a[0], a[1] }, velocity));
+		}
+		else if (event.action == "cube")
+		{
+			solver.pushCommand(Command::spawnCube({ a[0], a[1] }));
+		}
+		else if (event.action == "circle")
+		{
+			solver.pushCommand(Command::spawnCircle({ a[0], a[1] }, a[2], (int)a[3]));
+		}
+		else if (event.action == "fountain")
+		{
+			const float cubeChance = a.size() >= 4 ? a[3] : 0.0f;
+			if (rng.sampleUniform() < cubeChance)
+			{
+				solver.pushCommand(Command::spawnCube({ a[0], a[1] }));
+			}
+			else
+			{
+				const float angle = std::sin((float)tick / framerate) + Math::PI * 0.5f;
+				solver.pushCommand(Command::spawnParticle({ a[0], a[1] }, a[2] * sf::Vector2f(std::cos(angle), std::sin(angle))));
+			}
+		}
+		else if (event.action == "bridge")
+		{
+			solver.addChain(solver.addParticle({ a[0], a[1] }, true), solver.addParticle({ a[2], a[3] }, true));
+		}
+		else if (event.action == "wind")
+		{
+			solver.pushCommand(Command::make(CommandType::Wind));
+		}
+		else if (event.action == "force")
+		{
+			solver.pushCommand(Command::force({ a[0], a[1] }, a[2]));
+		}
+		return true;
+	};
+
+	ScenarioResult result;
+	result.name = name;
+	result.ticks = ticks;
+	std::vector<float> times;
+	times.reserve(ticks);
+	RenderState state;
+	CollisionGrid grid((int)worldSize.x, (int)worldSize.y, (int)(2 * radius));
+	double previousEnergy = 0.0;
+	double quietEnergyChange = 0.0;
+	int numQuietTicks = 0;
+	double penetrationSum = 0.0;
+	long long numOverlaps = 0;
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		// energy is only compared between ticks without actions
+		bool driven = false;
+		for (const ScenarioEvent& event : events)
+		{
+			const bool due = event.interval == 0 ? tick == event.start
+				: tick >= event.start && tick <= event.end && (tick - event.start) % event.interval == 0;
+			if (due && apply(event, tick))
+				driven = true;
+		}
+
+		// a tick is what the physics thread does for one frame
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		solver.update();
+		solver.writeRenderState(state);
+		times.push_back(std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count());
+		result.numDroppedObjects += solver.getStats().numDroppedObjects;
+		result.numDroppedLinks += solver.getStats().numDroppedLinks;
+
+		const double energy = getEnergy(solver);
+		if (tick > 0 && !driven && previousEnergy > 0.0)
+		{
+			quietEnergyChange += (energy - previousEnergy) / previousEnergy;
+			numQuietTicks++;
+		}
+		previousEnergy = energy;
+
+		// overlaps left after the tick, every pair of neighboring cells once
+		const std::vector<Particle>& particles = solver.getParticles().getData();
+		grid.clearGrid();
+		for (size_t i = 0; i < particles.size(); i++)
+			grid.addObject((civ::ID)i, particles[i].currentPosition, solver.getRadius(particles[i]));
+		for (int row = 0; row < grid.numRows; row++)
+		{
+			for (int col = 0; col < grid.numCols; col++)
+			{
+				const CollisionCell& cell = grid.getCell(row, col);
+				for (int i = std::max(row - 1, 0); i <= std::min(row + 1, grid.numRows - 1); i++)
+				{
+					for (int j = std::max(col - 1, 0); j <= std::min(col + 1, grid.numCols - 1); j++)
+					{
+						const CollisionCell& neighbor = grid.getCell(i, j);
+						for (int a = 0; a < cell.numObjects; a++)
+						{
+							for (int b = 0; b < neighbor.numObjects; b++)
+							{
+								if (cell.objects[a] >= neighbor.objects[b])
+									continue;
+								const Particle& p1 = particles[cell.objects[a]];
+								const Particle& p2 = particles[neighbor.objects[b]];
+								const float minDistance = solver.getRadius(p1) + solver.getRadius(p2);
+								const float overlap = (minDistance - Math::getDistance(p1.currentPosition, p2.currentPosition)) / minDistance;
+								if (overlap > 0.0f)
+								{
+									penetrationSum += overlap;
+									numOverlaps++;
+									result.maxPenetration = std::max(result.maxPenetration, overlap);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	result.numParticles = solver.getNumParticles();
+	result.numLinks = solver.getNumLinks();
+	if (!times.empty())
+	{
+		std::sort(times.begin(), times.end());
+		auto percentile = [&](float q) { return times[std::min(times.size() - 1, (size_t)(q * times.size()))]; };
+		result.p50 = percentile(0.5f);
+		result.p95 = percentile(0.95f);
+		result.p99 = percentile(0.99f);
+		result.max = times.back();
+	}
+	if (numQuietTicks > 0)
+		result.energyDrift = (float)(quietEnergyChange / numQuietTicks * framerate);
+	if (numOverlaps > 0)
+		result.meanPenetration = (float)(penetrationSum / numOverlaps);
+	return result;
+}
+
+bool Scenario::parseAction(ScenarioEvent& event, const std::string& action, std::istringstream& arguments, std::string& error)
+{
+	const auto known = ACTION_ARGUMENTS.find(action);
+	if (known == ACTION_ARGUMENTS.end())
+	{
+		error = "unknown action " + action;
+		return false;
+	}
+	float value;
+	while (arguments >> value)
+		event.arguments.push_back(value);
+	if (!arguments.eof() || (int)event.arguments.size() < known->second)
+	{
+		error = "invalid arguments of " + action;
+		return false;
+	}
+	event.action = action;
+	events.push_back(event);
+	return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <climits>
+#include <sstream>
+
+// action of a scenario, done once at start or every interval ticks from start to end
+struct ScenarioEvent
+{
+	int start = 0;
+	// 0 means only once
+	int interval = 0;
+	int end = INT_MAX;
+	std::string action;
+	std::vector<float> arguments;
+	// line in the file (for messages)
+	int line = 0;
+};
+
+// what a scenario measured
+struct ScenarioResult
+{
+	std::string name;
+	int ticks = 0;
+	int numParticles = 0;
+	int numLinks = 0;
+	// percentiles of the time of a tick (solver update and render state, in seconds)
+	float p50 = 0.0f, p95 = 0.0f, p99 = 0.0f, max = 0.0f;
+	// relative change of the total energy per second, averaged over the ticks in which no action put energy in
+	// (what the solver itself gains or loses, negative when it damps)
+	float energyDrift = 0.0f;
+	// overlap of touching particles relative to the sum of their radii, averaged over overlapping pairs and ticks
+	float meanPenetration = 0.0f;
+	float maxPenetration = 0.0f;
+	// grid entries of particles and links lost to full cells over all ticks (see SolverStats)
+	long long numDroppedObjects = 0;
+	long long numDroppedLinks = 0;
+};
+
+// reproducible scene of the macro benchmark, loaded from a text file and run headless for a fixed number of ticks
+//
+// every line is a setting or an action ('#' starts a comment):
+//   name <text>                      seed <n>
+//   world <width> <height>           radius <r>              framerate <fps>
+//   sub_steps <n>                    collision_iterations <n>
+//   constraint_iterations <n>        ticks <n>               max_particles <n>
+//   wind_area <x> <y> <width> <height> <speed> <strength>
+//   at <tick> <action>               (once)
+//   every <n> [from <tick>] [until <tick>] <action>
+// actions (spawning ones stop at max_particles):
+//   particle <x> <y> [<vx> <vy>]     cube <x> <y>            circle <x> <y> <radius> <count>
+//   fountain <x> <y> <speed> [<cube chance>]   (sweeps its angle with sin(time) like the demo)
+//   bridge <x1> <y1> <x2> <y2>       (chain between two pinned particles)
+//   wind                             force <x> <y> <radius>
+class Scenario
+{
+public:
+	// false if the file can't be read or has a line that isn't understood (see error)
+	bool load(const std::string& path, std::string& error);
+	ScenarioResult run();
+
+private:
+	bool parseAction(ScenarioEvent& event, const std::string& action, std::istringstream& arguments, std::string& error);
+
+	std::string name;
+	unsigned int seed = 1;
+	sf::Vector2f worldSize = { 500.0f, 300.0f };
+	float radius = 5.0f;
+	int framerate = 60;
+	int subSteps = 8;
+	int collisionIterations = 1;
+	int constraintIterations = 1;
+	int ticks = 600;
+	int maxParticles = 2000;
+	// position, size, speed and strength of every wind
+	std::vector<std::vector<float>> winds;
+	std::vector<ScenarioEvent> events;
+};
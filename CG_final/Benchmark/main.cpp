@@ -0,0 +1,289 @@
+#include "BenchmarkRunner.hpp"
+#include "Scenario.hpp"
+#include "Solver.hpp"
+#include "CollisionGrid.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// microbenchmarks of the solver kernels over synthetic data
+// options:
+// --baseline <file>   compare with an earlier run, the exit code is 1 if a kernel got slower than allowed
+// --save <file>       write the results so that they can be used as baseline
+// --threshold <x>     allowed slowdown of kernels without their own threshold in the baseline (default 0.1, 10%)
+// --filter <text>     only run kernels whose name contains the text
+// --time <seconds>    time spent on every result (default 0.5)
+// --scenario <file>   run a scripted scene (see Scenario.hpp) instead of the kernels, can be repeated,
+//                     its tick time percentiles are compared with the baseline like the kernels
+// --report <file>     write the tick times and quality measures of the scenarios as csv
+// baseline.json is the reference of the kernels (run with --baseline baseline.json from this folder)
+// timings depend on the machine, so refresh it with --save baseline.json from a release build on the machine
+// that compares, and after a change that is meant to make a kernel faster or slower
+
+constexpr unsigned int SEED = 1;
+constexpr float RADIUS = 5.0f;
+constexpr int CELL_SIZE = 10;
+constexpr float STEP_DT = 1.0f / 60.0f / 8.0f;
+
+// results are summed into this so that the compiler can't drop the kernels
+volatile float sink = 0.0f;
+
+// random particles in a square that has (on average) density particles per grid cell
+static std::vector<Particle> makeParticles(RNG& rng, int count, float density, float& worldSize)
+{
+	worldSize = std::ceil(std::sqrt(count / density)) * CELL_SIZE;
+	std::vector<Particle> particles(count);
+	for (Particle& particle : particles)
+	{
+		particle = Particle({ rng.sampleFromRange(RADIUS, worldSize - RADIUS), rng.sampleFromRange(RADIUS, worldSize - RADIUS) });
+		particle.initVelocity({ rng.sampleFromRange(-50.0f, 50.0f), rng.sampleFromRange(-50.0f, 50.0f) }, STEP_DT);
+	}
+	return particles;
+}
+
+// save the results and turn the regressions into the exit code
+static int finish(BenchmarkRunner& runner, const std::string& savePath)
+{
+	if (!savePath.empty() && !runner.saveResults(savePath))
+		std::cout << "can't write results to " << savePath << std::endl;
+	if (runner.getNumRegressions() > 0)
+	{
+		std::cout << runner.getNumRegressions() << " regression(s)" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// a scenario is run once, an element is a tick (the size is the number of ticks)
+static int runScenarios(BenchmarkRunner& runner, const std::vector<std::string>& paths, const std::string& savePath, const std::string& reportPath)
+{
+	std::vector<ScenarioResult> results;
+	for (const std::string& path : paths)
+	{
+		Scenario scenario;
+		std::string error;
+		if (!scenario.load(path, error))
+		{
+			std::cout << error << std::endl;
+			return 2;
+		}
+		const ScenarioResult result = scenario.run();
+		runner.addScenario(result.name, result.ticks, result.p50, result.p95, result.p99);
+		std::printf("  %d particles, %d links, max tick %.2f ms, energy drift %+.2f%%, penetration %.2f%% mean %.2f%% max\n",
+			result.numParticles, result.numLinks, result.max * 1e3f, 100.0f * result.energyDrift,
+			100.0f * result.meanPenetration, 100.0f * result.maxPenetration);
+		std::printf("  dropped by full cells: %lld particles, %lld links\n", result.numDroppedObjects, result.numDroppedLinks);
+		results.push_back(result);
+	}
+
+	if (!reportPath.empty())
+	{
+		std::ofstream report(reportPath);
+		if (report)
+		{
+			report << "name,ticks,particles,links,p50_ms,p95_ms,p99_ms,max_ms,energy_drift,mean_penetration,max_penetration,dropped_objects,dropped_links\n";
+			for (const ScenarioResult& result : results)
+			{
+				report << result.name << "," << result.ticks << "," << result.numParticles << "," << result.numLinks << ","
+					<< result.p50 * 1e3f << "," << result.p95 * 1e3f << "," << result.p99 * 1e3f << "," << result.max * 1e3f << ","
+					<< result.energyDrift << "," << result.meanPenetration << "," << result.maxPenetration << ","
+					<< result.numDroppedObjects << "," << result.numDroppedLinks << "\n";
+			}
+		}
+		else
+		{
+			std::cout << "can't write report to " << reportPath << std::endl;
+		}
+	}
+	return finish(runner, savePath);
+}
+
+int main(int argc, char* argv[])
+{
+	std::string baselinePath, savePath, filter, reportPath;
+	std::vector<std::string> scenarioPaths;
+	float threshold = 0.1f;
+	double time = 0.5;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const std::string option = argv[i];
+		if (option == "--baseline")
+			baselinePath = argv[i + 1];
+		else if (option == "--save")
+			savePath = argv[i + 1];
+		else if (option == "--threshold")
+			threshold = (float)std::atof(argv[i + 1]);
+		else if (option == "--filter")
+			filter = argv[i + 1];
+		else if (option == "--time")
+			time = std::atof(argv[i + 1]);
+		else if (option == "--scenario")
+			scenarioPaths.push_back(argv[i + 1]);
+		else if (option == "--report")
+			reportPath = argv[i + 1];
+	}
+
+	BenchmarkRunner runner(time);
+	runner.setFilter(filter);
+	runner.setThreshold(threshold);
+	if (!baselinePath.empty() && !runner.loadBaseline(baselinePath))
+		std::cout << "can't read baseline " << baselinePath << std::endl;
+
+	if (!scenarioPaths.empty())
+		return runScenarios(runner, scenarioPaths, savePath, reportPath);
+
+	RNG rng;
+	const int sizes[] = { 1000, 10000, 100000 };
+	for (int size : sizes)
+	{
+		// Verlet integration
+		{
+			rng.generator.seed(SEED);
+			float worldSize;
+			const std::vector<Particle> start = makeParticles(rng, size, 1.0f, worldSize);
+			std::vector<Particle> particles = start;
+			// put back so that the positions don't grow out of range over many runs
+			runner.run("particle_update", size, 0.0f, size, [&] {
+				particles = start;
+			}, [&] {
+				for (Particle& particle : particles)
+				{
+					particle.applyForce({ 0.0f, 1000.0f });
+					particle.update(STEP_DT);
+				}
+				sink = sink + particles.back().currentPosition.x;
+			});
+		}
+
+		// XPBD distance constraints along a stretched chain, stiff and soft
+		for (float compliance : { 0.0f, 0.001f })
+		{
+			const char* name = compliance == 0.0f ? "constraint_update" : "constraint_update_soft";
+			rng.generator.seed(SEED);
+			civ::IndexVector<Particle> particles;
+			std::vector<Constraint> links;
+			particles.reserve(size + 1);
+			links.reserve(size);
+			for (int i = 0; i <= size; i++)
+				particles.push_back(Particle({ i * 2.0f * RADIUS * 1.1f, rng.sampleFromRange(-RADIUS, RADIUS) }));
+			for (int i = 0; i < size; i++)
+				links.emplace_back(particles.createRef(i), particles.createRef(i + 1), 2.0f * RADIUS, compliance);
+			runner.run(name, size, 0.0f, size, [&] {
+				for (Constraint& link : links)
+					link.lambda = 0.0f;
+			}, [&] {
+				for (Constraint& link : links)
+					link.update(STEP_DT);
+				sink = sink + links.back().strain;
+			});
+		}
+
+		for (float density : { 0.25f, 1.0f, 2.0f })
+		{
+			rng.generator.seed(SEED);
+			float worldSize;
+			const std::vector<Particle> start = makeParticles(rng, size, density, worldSize);
+
+			// particle pairs of neighboring cells like the grid collision produces them (each pair once),
+			// the particles are put back before every run so that the number of contacts stays the same
+			Solver solver({ worldSize, worldSize }, RADIUS, CELL_SIZE);
+			CollisionGrid& grid = solver.getGrid();
+			for (int i = 0; i < size; i++)
+				grid.addObject(i, start[i].currentPosition, RADIUS);
+			std::vector<std::pair<civ::ID, civ::ID>> pairs;
+			for (int row = 0; row < grid.numRows; row++)
+			{
+				for (int col = 0; col < grid.numCols; col++)
+				{
+					const CollisionCell& cell = grid.getCell(row, col);
+					for (int i = -1; i <= 1; i++)
+					{
+						for (int j = -1; j <= 1; j++)
+						{
+							if (row + i < 0 || row + i >= grid.numRows || col + j < 0 || col + j >= grid.numCols)
+								continue;
+							const CollisionCell& neighbor = grid.getCell(row + i, col + j);
+							for (int a = 0; a < cell.numObjects; a++)
+							{
+								for (int b = 0; b < neighbor.numObjects; b++)
+								{
+									if (cell.objects[a] < neighbor.objects[b])
+										pairs.push_back({ cell.objects[a], neighbor.objects[b] });
+								}
+							}
+						}
+					}
+				}
+			}
+			std::vector<Particle> particles = start;
+			runner.run("particle_collision", size, density, pairs.size(), [&] {
+				particles = start;
+			}, [&] {
+				for (const std::pair<civ::ID, civ::ID>& pair : pairs)
+					solver.solveParticleCollision(&particles[pair.first], &particles[pair.second]);
+				sink = sink + particles.back().currentPosition.x;
+			});
+
+			// grid insertion (clearing isn't timed)
+			runner.run("grid_add_object", size, density, size, [&] {
+				grid.clearGrid();
+			}, [&] {
+				for (int i = 0; i < size; i++)
+					grid.addObject(i, start[i].currentPosition, RADIUS);
+				sink = sink + (float)grid.grid[0].numObjects;
+			});
+		}
+
+		// IndexVector operations
+		{
+			rng.generator.seed(SEED);
+			float worldSize;
+			const std::vector<Particle> source = makeParticles(rng, size, 1.0f, worldSize);
+			std::vector<civ::ID> ids(size);
+			for (int i = 0; i < size; i++)
+				ids[i] = i;
+			std::shuffle(ids.begin(), ids.end(), rng.generator);
+			civ::IndexVector<Particle> vector;
+			auto fill = [&] {
+				vector = civ::IndexVector<Particle>();
+				for (const Particle& particle : source)
+					vector.push_back(particle);
+			};
+
+			runner.run("index_vector_push_back", size, 0.0f, size, [&] {
+				vector = civ::IndexVector<Particle>();
+			}, [&] {
+				for (const Particle& particle : source)
+					vector.push_back(particle);
+				sink = sink + (float)vector.size();
+			});
+			// half of the objects in random order
+			runner.run("index_vector_erase", size, 0.0f, size / 2, fill, [&] {
+				for (int i = 0; i < size / 2; i++)
+					vector.erase(ids[i]);
+				sink = sink + (float)vector.size();
+			});
+			fill();
+			runner.run("index_vector_lookup", size, 0.0f, size, [] {}, [&] {
+				float sum = 0.0f;
+				for (civ::ID id : ids)
+					sum += vector[id].currentPosition.x;
+				sink = sink + sum;
+			});
+			runner.run("index_vector_iterate", size, 0.0f, size, [] {}, [&] {
+				float sum = 0.0f;
+				for (const Particle& particle : vector)
+					sum += particle.currentPosition.x;
+				sink = sink + sum;
+			});
+		}
+	}
+
+	return finish(runner, savePath);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include "BodyStorage.hpp"
+
+// keep the area enclosed by a closed ring of particles at a target value (soft body pressure)
+struct AreaConstraint
+{
+	// range of the particles of the ring (in order) and their area gradients in the body storage
+	int first = 0;
+	int count = 0;
+	// signed area of the ring at rest
+	float restArea = 0.0f;
+	// the target area is restArea * pressure (higher than 1 inflates the ring like a balloon)
+	float pressure = 1.0f;
+	// compliance of the constraint (inverse of stiffness, 0 means incompressible)
+	float compliance = 0.0f;
+	// accumulated Lagrange multiplier of XPBD (reset at the beginning of every sub-step)
+	float lambda = 0.0f;
+
+	AreaConstraint() = default;
+	// the current area of the ring is the rest area
+	AreaConstraint(BodyStorage& bodies, const civ::Ref<Particle>* refs, int count, float compliance, float pressure = 1.0f)
+		:first(bodies.add(refs, count)), count(count), pressure(pressure), compliance(compliance)
+	{
+		restArea = getArea(bodies);
+	}
+
+	bool isValid(const BodyStorage& bodies)
+	{
+		for (int i = first; i < first + count; i++)
+		{
+			if (!bodies.particles[i])
+				return false;
+		}
+		return count >= 3;
+	}
+
+	// signed area with the shoelace formula
+	float getArea(BodyStorage& bodies)
+	{
+		float area = 0.0f;
+		for (int i = 0; i < count; i++)
+		{
+			const sf::Vector2f& a = bodies.particles[first + i]->currentPosition;
+			const sf::Vector2f& b = bodies.particles[first + (i + 1) % count]->currentPosition;
+			area += a.x * b.y - a.y * b.x;
+		}
+		return 0.5f * area;
+	}
+
+	// solve the constraint once with XPBD, getInverseMass gives the inverse mass of a particle
+	template<typename TInverseMass>
+	void update(float dt, BodyStorage& bodies, TInverseMass&& getInverseMass)
+	{
+		if (!isValid(bodies))
+			return;
+
+		civ::Ref<Particle>* particles = &bodies.particles[first];
+		sf::Vector2f* gradients = &bodies.vectors[first];
+		const float c = getArea(bodies) - restArea * pressure;
+		// gradient of the area for particle i is 0.5 * perpendicular of (next - previous)
+		float sum = 0.0f;
+		for (int i = 0; i < count; i++)
+		{
+			const sf::Vector2f& previous = particles[(i + count - 1) % count]->currentPosition;
+			const sf::Vector2f& next = particles[(i + 1) % count]->currentPosition;
+			gradients[i] = 0.5f * sf::Vector2f(next.y - previous.y, previous.x - next.x);
+			sum += getInverseMass(*particles[i]) * (gradients[i].x * gradients[i].x + gradients[i].y * gradients[i].y);
+		}
+		const float alpha = compliance / (dt * dt);
+		if (sum + alpha == 0.0f)
+			return;
+
+		const float deltaLambda = (-c - alpha * lambda) / (sum + alpha);
+		lambda += deltaLambda;
+		for (int i = 0; i < count; i++)
+		{
+			particles[i]->move(getInverseMass(*particles[i]) * deltaLambda * gradients[i]);
+		}
+	}
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+
+// bump allocator for temporary arrays that only live until the next reset (usually one frame)
+// memory is kept between resets, so it stops allocating once it has reached its peak size
+class Arena
+{
+public:
+	Arena(size_t capacity = 4096)
+	{
+		blocks.emplace_back(capacity);
+	}
+
+	template<typename T>
+	T* allocate(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "objects in arena are never destroyed");
+		const size_t size = count * sizeof(T);
+		Block* block = &blocks.back();
+		size_t offset = align(block->used, alignof(T));
+		if (offset + size > block->data.size())
+		{
+			// previous blocks are kept until reset so that given pointers stay valid
+			blocks.emplace_back(std::max(size + alignof(T), 2 * block->data.size()));
+			block = &blocks.back();
+			offset = 0;
+		}
+		block->used = offset + size;
+
+		T* objects = reinterpret_cast<T*>(block->data.data() + offset);
+		for (size_t i = 0; i < count; i++)
+		{
+			new (objects + i) T();
+		}
+		return objects;
+	}
+
+	void reset()
+	{
+		// merge all blocks into one that is big enough for the peak usage
+		if (blocks.size() > 1)
+		{
+			const size_t capacity = getCapacity();
+			blocks.clear();
+			blocks.emplace_back(capacity);
+		}
+		blocks.back().used = 0;
+	}
+
+	size_t getUsed() const
+	{
+		size_t used = 0;
+		for (const Block& block : blocks)
+		{
+			used += block.used;
+		}
+		return used;
+	}
+
+	size_t getCapacity() const
+	{
+		size_t capacity = 0;
+		for (const Block& block : blocks)
+		{
+			capacity += block.data.size();
+		}
+		return capacity;
+	}
+
+private:
+	struct Block
+	{
+		std::vector<char> data;
+		size_t used = 0;
+
+		Block(size_t size) :data(size) {}
+	};
+
+	static size_t align(size_t offset, size_t alignment)
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	std::vector<Block> blocks;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+#include "Particle.hpp"
+#include "ConstantIndexVector/index_vector.hpp"
+
+// particles and constraints that are added to the solver in one step
+// constraints refer to particles by their index in the batch
+struct Batch
+{
+	struct ParticleEntry
+	{
+		sf::Vector2f position;
+		bool pinned = false;
+		// already existing particle that new constraints can be attached to
+		bool existing = false;
+		civ::Ref<Particle> ref;
+	};
+
+	struct ConstraintEntry
+	{
+		int p1, p2;
+		float compliance;
+		bool collidable;
+	};
+
+	std::vector<ParticleEntry> particles;
+	std::vector<ConstraintEntry> constraints;
+	int numNewParticles = 0;
+
+	int addParticle(const sf::Vector2f& position, bool pinned = false)
+	{
+		particles.push_back({ position, pinned, false, civ::Ref<Particle>() });
+		numNewParticles++;
+		return (int)particles.size() - 1;
+	}
+
+	int addExisting(civ::Ref<Particle> particle)
+	{
+		particles.push_back({ particle->currentPosition, particle->pinned, true, particle });
+		return (int)particles.size() - 1;
+	}
+
+	// the length of the constraint is the distance between the two particles
+	void addConstraint(int p1, int p2, float compliance = 0.0f, bool collidable = false)
+	{
+		constraints.push_back({ p1, p2, compliance, collidable });
+	}
+
+	void clear()
+	{
+		// vectors keep their capacity so that building a batch doesn't allocate once warmed up
+		particles.clear();
+		constraints.clear();
+		numNewParticles = 0;
+	}
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "Particle.hpp"
+#include "ConstantIndexVector/index_vector.hpp"
+
+// per-particle data of the shape and area constraints, stored in flat arrays owned by the solver
+// a body only keeps the first index and the size of its range, so adding one doesn't allocate
+// (the arrays grow geometrically like the other storage of the solver)
+struct BodyStorage
+{
+	std::vector<civ::Ref<Particle>> particles;
+	// rest offsets of shapes, gradients of areas
+	std::vector<sf::Vector2f> vectors;
+	// accumulated Lagrange multipliers of XPBD, one per particle of a shape (reset at the beginning of every sub-step)
+	std::vector<float> lambdas;
+
+	// append a range for count particles, returns its first index
+	int add(const civ::Ref<Particle>* refs, int count)
+	{
+		const int first = (int)particles.size();
+		particles.insert(particles.end(), refs, refs + count);
+		vectors.resize(particles.size());
+		lambdas.resize(particles.size());
+		return first;
+	}
+
+	// move the range [first, first + count) to start at destination (destination <= first)
+	void move(int first, int count, int destination)
+	{
+		std::copy(particles.begin() + first, particles.begin() + first + count, particles.begin() + destination);
+		std::copy(vectors.begin() + first, vectors.begin() + first + count, vectors.begin() + destination);
+		std::copy(lambdas.begin() + first, lambdas.begin() + first + count, lambdas.begin() + destination);
+	}
+
+	// whether every particle of the range is coarse (stepped every lodRatio sub-steps)
+	bool isCoarse(int first, int count) const
+	{
+		for (int i = first; i < first + count; i++)
+		{
+			if (!particles[i] || !particles[i]->coarse)
+				return false;
+		}
+		return count > 0;
+	}
+
+	void resize(int size)
+	{
+		particles.resize(size);
+		vectors.resize(size);
+		lambdas.resize(size);
+	}
+
+	size_t getBytes() const
+	{
+		return particles.capacity() * sizeof(civ::Ref<Particle>) + vectors.capacity() * sizeof(sf::Vector2f)
+			+ lambdas.capacity() * sizeof(float);
+	}
+};
@@ -0,0 +1,112 @@
+#include "ChainRenderer.hpp"
+#include "Math.hpp"
+#include <algorithm>
+
+ChainRenderer::ChainRenderer(float width, int steps) : width(width), steps(steps), vertices(sf::TriangleStrip)
+{
+}
+
+void ChainRenderer::update(const RenderState& frame, const sf::FloatRect& area)
+{
+	// the vertex array keeps its memory, so this doesn't allocate once warmed up
+	vertices.clear();
+	// a segment stays inside of the bounding box of its four control points (and the strip width)
+	visibleArea = sf::FloatRect(area.left - width, area.top - width, area.width + 2.0f * width, area.height + 2.0f * width);
+	for (size_t i = 0; i + 1 < frame.chainStarts.size(); i++)
+	{
+		const int start = frame.chainStarts[i];
+		addChain(&frame.chainPoints[start], &frame.chainStrains[start], frame.chainStarts[i + 1] - start);
+	}
+}
+
+void ChainRenderer::setStrainRange(float range)
+{
+	strainRange = range;
+}
+
+void ChainRenderer::draw(RenderContext& context, sf::RenderStates& states)
+{
+	if (vertices.getVertexCount() > 0)
+		context.draw(vertices, states);
+}
+
+void ChainRenderer::addChain(const sf::Vector2f* points, const float* strains, int count)
+{
+	// a closed chain repeats its first point, so the curve wraps around
+	const bool closed = count > 3 && points[0] == points[count - 1];
+	const int last = count - 1;
+	auto getPoint = [&](int i) -> sf::Vector2f
+	{
+		if (i < 0)
+			return closed ? points[last - 1] : 2.0f * points[0] - points[1];
+		if (i > last)
+			return closed ? points[1] : 2.0f * points[last] - points[last - 1];
+		return points[i];
+	};
+
+	// only visible segments are added, every run of them is a separate piece of the strip
+	bool inRun = false;
+	for (int i = 0; i < last; i++)
+	{
+		const sf::Vector2f p0 = getPoint(i - 1);
+		const sf::Vector2f p1 = points[i];
+		const sf::Vector2f p2 = points[i + 1];
+		const sf::Vector2f p3 = getPoint(i + 2);
+		const float left = std::min(std::min(p0.x, p1.x), std::min(p2.x, p3.x));
+		const float top = std::min(std::min(p0.y, p1.y), std::min(p2.y, p3.y));
+		const float right = std::max(std::max(p0.x, p1.x), std::max(p2.x, p3.x));
+		const float bottom = std::max(std::max(p0.y, p1.y), std::max(p2.y, p3.y));
+		// (not Rect::intersects, which misses boxes without height like the ones of straight horizontal chains)
+		if (right < visibleArea.left || left > visibleArea.left + visibleArea.width || bottom < visibleArea.top || top > visibleArea.top + visibleArea.height)
+		{
+			inRun = false;
+			continue;
+		}
+
+		// polynomial coefficients of the segment, p(t) = p1 + b t + c t^2 + d t^3
+		const sf::Vector2f b = 0.5f * (p2 - p0);
+		const sf::Vector2f c = 0.5f * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3);
+		const sf::Vector2f d = 0.5f * (-p0 + 3.0f * p1 - 3.0f * p2 + p3);
+		// the strain is blended between the two points in the same write
+		const float strain1 = strains[i];
+		const float strain2 = strains[i + 1];
+		if (!inRun)
+		{
+			// join with the previous piece by repeating its last vertex and the first one of this piece
+			const size_t numVertices = vertices.getVertexCount();
+			if (numVertices > 0)
+			{
+				vertices.append(vertices[numVertices - 1]);
+				vertices.append(sf::Vertex(p1 + getNormal(b), getColor(strain1)));
+			}
+			addPoint(p1, b, getColor(strain1));
+			inRun = true;
+		}
+		for (int s = 1; s <= steps; s++)
+		{
+			const float t = (float)s / steps;
+			addPoint(p1 + t * (b + t * (c + t * d)), b + t * (2.0f * c + 3.0f * t * d), getColor(strain1 + t * (strain2 - strain1)));
+		}
+	}
+}
+
+void ChainRenderer::addPoint(const sf::Vector2f& position, const sf::Vector2f& tangent, const sf::Color& color)
+{
+	const sf::Vector2f normal = getNormal(tangent);
+	vertices.append(sf::Vertex(position + normal, color));
+	vertices.append(sf::Vertex(position - normal, color));
+}
+
+sf::Vector2f ChainRenderer::getNormal(const sf::Vector2f& tangent)
+{
+	const float length = Math::getLength(tangent);
+	// particles on top of each other don't have a direction, keep the strip thin there
+	if (length == 0.0f)
+		return { 0.0f, 0.0f };
+	return sf::Vector2f(-tangent.y, tangent.x) * (width / length);
+}
+
+sf::Color ChainRenderer::getColor(float strain)
+{
+	return strainRange > 0.0f ? ColorRamp::getStrain(strain, strainRange) : color;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "RenderContext.hpp"
+#include "RenderState.hpp"
+#include "ColorRamp.hpp"
+
+// draw every chain as a smooth strip through its particles (Catmull-Rom curve)
+// all chains are written into one vertex array and drawn at once
+class ChainRenderer
+{
+public:
+	// width is the half thickness of a strip, steps is the number of points per link
+	ChainRenderer(float width, int steps);
+
+	// rebuild the strips from the chains of a frame (segments outside of area are skipped)
+	void update(const RenderState& frame, const sf::FloatRect& area);
+	// colour the strips by the strain of their links (range is the strain of the full colour, 0 draws them plain)
+	void setStrainRange(float range);
+	void draw(RenderContext& context, sf::RenderStates& states);
+
+private:
+	void addChain(const sf::Vector2f* points, const float* strains, int count);
+	void addPoint(const sf::Vector2f& position, const sf::Vector2f& tangent, const sf::Color& color);
+	sf::Color getColor(float strain);
+	// offset from the center line to the side of the strip
+	sf::Vector2f getNormal(const sf::Vector2f& tangent);
+
+	float width;
+	int steps;
+	sf::Color color = sf::Color::Red;
+	float strainRange = 0.0f;
+	// area of the current update grown by the width
+	sf::FloatRect visibleArea;
+	// triangle strip, chains are joined by degenerate triangles
+	sf::VertexArray vertices;
+};
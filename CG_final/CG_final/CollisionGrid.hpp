@@ -1,31 +1,52 @@
 #pragma once
 #include <SFML/Graphics.hpp>
 #include "Particle.hpp"
+#include "Math.hpp"
+#include "ConstantIndexVector/index_vector.hpp"
 #include <vector>
 #include <unordered_map>
 #include <array>
+#include <cmath>
 #include <iostream>
 
 constexpr int CELL_CAPACITY = 10;
+// long links are inserted into every cell they pass through, so dense bridges need more slots than particles
+constexpr int LINK_CAPACITY = 16;
 
+// cells store 32 bits data indices of particles and links instead of pointers
 struct CollisionCell
 {
 	int numObjects = 0;
 	//Particle* objects[CELL_CAPACITY] = {};
-	std::array<Particle*, CELL_CAPACITY> objects = { nullptr };
+	std::array<civ::ID, CELL_CAPACITY> objects = { 0 };
 	//std::vector<Particle*> objects;
+	// links (treated as capsules) that pass through this cell
+	int numLinks = 0;
+	std::array<civ::ID, LINK_CAPACITY> links = { 0 };
 
-	void addObject(Particle* object)
+	// false if the cell is full (the object isn't stored and won't collide in this step)
+	bool addObject(civ::ID object)
 	{
-		objects[numObjects] = object;
+		if (numObjects >= CELL_CAPACITY)
+			return false;
+		objects[numObjects++] = object;
 		//objects.push_back(object);
-		numObjects = numObjects + 1 >= CELL_CAPACITY ? numObjects : numObjects + 1;
+		return true;
+	}
+
+	bool addLink(civ::ID link)
+	{
+		if (numLinks >= LINK_CAPACITY)
+			return false;
+		links[numLinks++] = link;
+		return true;
 	}
 
 	void clear()
 	{
 		//objects.clear();
 		numObjects = 0;
+		numLinks = 0;
 	}
 };
 
@@ -66,15 +87,38 @@ struct CollisionGrid
 		return { row, col };
 	}
 
-	void addObject(Particle& object)
+	// false if the cell of the object was full
+	bool addObject(civ::ID index, const sf::Vector2f& position, float radius)
 	{
-		const sf::Vector2f position = object.currentPosition;
 		// top-left side of the object
-		//const sf::Vector2f minPosition = position - sf::Vector2f(object.radius, object.radius);
+		//const sf::Vector2f minPosition = position - sf::Vector2f(radius, radius);
 		// bottom-right side of the object
-		//const sf::Vector2f maxPosition = position + sf::Vector2f(object.radius, object.radius);
+		//const sf::Vector2f maxPosition = position + sf::Vector2f(radius, radius);
+
+		sf::Vector2i coord = getGridCoordinate(position, radius);
+		return getCell(coord.x, coord.y).addObject(index);
+	}
 
-		sf::Vector2i coord = getGridCoordinate(position, object.radius);
-		getCell(coord.x, coord.y).addObject(&object);
+	// returns the number of cells that were full and didn't get the link
+	int addLink(civ::ID index, const sf::Vector2f& start, const sf::Vector2f& end, float radius)
+	{
+		// walk along the link with half cell steps so that every cell it passes through gets it
+		const float length = Math::getLength(end - start);
+		const int numSteps = (int)(2.0f * length / cellSize) + 1;
+		sf::Vector2i lastCoord(-1, -1);
+		int numDropped = 0;
+		for (int i = 0; i <= numSteps; i++)
+		{
+			const float t = (float)i / numSteps;
+			sf::Vector2i coord = getGridCoordinate(start + t * (end - start), radius);
+			// don't insert the same link into the same cell twice
+			if (coord != lastCoord)
+			{
+				if (!getCell(coord.x, coord.y).addLink(index))
+					numDropped++;
+				lastCoord = coord;
+			}
+		}
+		return numDropped;
 	}
 };
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+#include <SFML/Graphics/Color.hpp>
+#include <algorithm>
+#include <cmath>
+
+// colour ramps of the debug views
+struct ColorRamp
+{
+	// from blue (0) over green (0.5) to red (1), values outside are clamped
+	static sf::Color get(float value)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+		auto channel = [](float x) { return (sf::Uint8)(255.0f * std::min(std::max(1.5f - std::abs(x), 0.0f), 1.0f)); };
+		return sf::Color(channel(4.0f * value - 3.0f), channel(4.0f * value - 2.0f), channel(4.0f * value - 1.0f));
+	}
+
+	// compressed links are blue, links at rest green and stretched ones red (range is the strain of the full colour)
+	static sf::Color getStrain(float strain, float range)
+	{
+		return get(0.5f + 0.5f * strain / range);
+	}
+};
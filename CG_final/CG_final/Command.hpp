@@ -0,0 +1,101 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+
+enum class CommandType : uint8_t
+{
+	SpawnParticle,
+	SpawnCube,
+	SpawnCircle,
+	// toggle the pin of the particle at position
+	Pin,
+	// chain the particles at position and target
+	Chain,
+	Force,
+	// pull the nearest particle toward position
+	Grab,
+	// remove the particle at position and everything attached to it
+	Remove,
+	Wind,
+	ToggleCollisionMode,
+	// particles linked one after another along a stroke, the points are kept by the solver
+	SpawnStrip
+};
+
+// simulation action sent from the input to the solver
+// (plain data, so that it can be queued between threads and recorded)
+struct Command
+{
+	CommandType type = CommandType::Wind;
+	sf::Vector2f position;
+	// velocity of a spawned particle or the other end of a chain
+	sf::Vector2f target;
+	// radius of a force or a circle
+	float radius = 0.0f;
+	// number of particles of a circle or points of a strip
+	int count = 0;
+	// first point of a strip in the points kept by the solver (a command can't hold a variable number of points)
+	int first = 0;
+	bool pinned = false;
+	// only spawn if there is no particle at position
+	bool ifFree = false;
+	// frame in which the command was applied (set by the solver)
+	uint32_t frame = 0;
+
+	static Command spawnParticle(const sf::Vector2f& position, const sf::Vector2f& velocity, bool pinned = false, bool ifFree = false)
+	{
+		Command command = make(CommandType::SpawnParticle, position);
+		command.target = velocity;
+		command.pinned = pinned;
+		command.ifFree = ifFree;
+		return command;
+	}
+
+	static Command spawnCube(const sf::Vector2f& position, bool pinned = false, bool ifFree = false)
+	{
+		Command command = make(CommandType::SpawnCube, position);
+		command.pinned = pinned;
+		command.ifFree = ifFree;
+		return command;
+	}
+
+	static Command spawnCircle(const sf::Vector2f& position, float radius, int count, bool ifFree = false)
+	{
+		Command command = make(CommandType::SpawnCircle, position);
+		command.radius = radius;
+		command.count = count;
+		command.ifFree = ifFree;
+		return command;
+	}
+
+	static Command spawnStrip(int first, int count, bool pinEnds)
+	{
+		Command command = make(CommandType::SpawnStrip);
+		command.first = first;
+		command.count = count;
+		command.pinned = pinEnds;
+		return command;
+	}
+
+	static Command chain(const sf::Vector2f& start, const sf::Vector2f& end)
+	{
+		Command command = make(CommandType::Chain, start);
+		command.target = end;
+		return command;
+	}
+
+	static Command force(const sf::Vector2f& position, float radius)
+	{
+		Command command = make(CommandType::Force, position);
+		command.radius = radius;
+		return command;
+	}
+
+	static Command make(CommandType type, const sf::Vector2f& position = {})
+	{
+		Command command;
+		command.type = type;
+		command.position = position;
+		return command;
+	}
+};
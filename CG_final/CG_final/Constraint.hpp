@@ -9,13 +9,19 @@ struct Constraint
 	civ::Ref<Particle> p1, p2;
 	// length of the constraint (also the max distance that two particles can separate)
 	float length;
-	// strength of the constraint (the higher it is, the stiffer the constraint is)
-	// this value should be between 0 and 1
-	float strength;
+	// compliance of the constraint (inverse of stiffness, 0 means infinitely stiff)
+	// unlike a 0-1 strength, the resulting stiffness doesn't depend on sub-steps or dt
+	float compliance = 0.0f;
+	// accumulated Lagrange multiplier of XPBD (reset at the beginning of every sub-step)
+	float lambda = 0.0f;
+	// relative stretch found by the last solve, (distance - length) / length (negative when compressed)
+	float strain = 0.0f;
+	// whether the link is treated as a capsule that particles can collide with
+	bool collidable = false;
 
 	Constraint() = default;
-	Constraint(civ::Ref<Particle> p1, civ::Ref<Particle> p2, float length, float strength)
-		:p1(p1), p2(p2), length(length), strength(strength) {}
+	Constraint(civ::Ref<Particle> p1, civ::Ref<Particle> p2, float length, float compliance, bool collidable = false)
+		:p1(p1), p2(p2), length(length), compliance(compliance), collidable(collidable) {}
 
 
 	bool isValid()
@@ -24,20 +30,27 @@ struct Constraint
 		return p1 && p2;
 	}
 
-	void update(float dt)
+	// solve the constraint once with XPBD (extended position-based dynamics)
+	// w1 and w2 are the inverse masses of the two particles (0 for pinned ones)
+	void update(float dt, float w1 = 1.0f, float w2 = 1.0f)
 	{
 		if (!isValid())
 			return;
 
 		sf::Vector2f direction = p1->currentPosition - p2->currentPosition;
 		float distance = Math::getLength(direction);
-		// if the distance between two particles is further than length, put them back
+		strain = length > 0.0f ? (distance - length) / length : 0.0f;
+		if (w1 + w2 == 0.0f || distance == 0.0f)
+			return;
+
+		// if the distance between two particles is different from length, put them back
 		sf::Vector2f unit = direction / distance;
-		const float delta = 0.5f * strength * (length - distance);
-		// only update distance if particles are not pinned
-		if (!p1->pinned)
-			p1->move(unit * delta);
-		if (!p2->pinned)
-			p2->move(-unit * delta);
+		const float c = distance - length;
+		// compliance scaled by time step
+		const float alpha = compliance / (dt * dt);
+		const float deltaLambda = (-c - alpha * lambda) / (w1 + w2 + alpha);
+		lambda += deltaLambda;
+		p1->move(unit * (w1 * deltaLambda));
+		p2->move(-unit * (w2 * deltaLambda));
 	}
 };
\ No newline at end of file
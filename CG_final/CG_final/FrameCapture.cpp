@@ -0,0 +1,282 @@
+#include "FrameCapture.hpp"
+#include <SFML/OpenGL.hpp>
+#include <cstring>
+#include <cctype>
+#include <cstddef>
+#include <type_traits>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+// number of pixel buffers, a frame is mapped this many pushes after its copy started
+constexpr int NUM_READBACKS = 2;
+
+// pixel buffer objects are OpenGL 2.1 and not in the OpenGL 1.1 header of Windows, so they are loaded at runtime
+constexpr GLenum PIXEL_PACK_BUFFER = 0x88EB;
+constexpr GLenum STREAM_READ = 0x88E1;
+constexpr GLenum READ_ONLY = 0x88B8;
+struct PixelBufferFunctions
+{
+	void (APIENTRY* genBuffers)(GLsizei, GLuint*) = nullptr;
+	void (APIENTRY* deleteBuffers)(GLsizei, const GLuint*) = nullptr;
+	void (APIENTRY* bindBuffer)(GLenum, GLuint) = nullptr;
+	void (APIENTRY* bufferData)(GLenum, std::ptrdiff_t, const void*, GLenum) = nullptr;
+	void* (APIENTRY* mapBuffer)(GLenum, GLenum) = nullptr;
+	GLboolean(APIENTRY* unmapBuffer)(GLenum) = nullptr;
+
+	// needs an active context, false if the driver doesn't have them
+	// (drivers with them are OpenGL 2.1, so textures aren't padded to powers of two and glGetTexImage fits the buffer)
+	bool load()
+	{
+		auto get = [](auto& function, const char* name) {
+			function = reinterpret_cast<std::remove_reference_t<decltype(function)>>(sf::Context::getFunction(name));
+			return function != nullptr;
+		};
+		return get(genBuffers, "glGenBuffers") && get(deleteBuffers, "glDeleteBuffers") && get(bindBuffer, "glBindBuffer")
+			&& get(bufferData, "glBufferData") && get(mapBuffer, "glMapBuffer") && get(unmapBuffer, "glUnmapBuffer");
+	}
+};
+static PixelBufferFunctions gl;
+
+// a file pattern has to contain exactly one integer conversion (%d, %5d or %05d), any other conversion
+// would make snprintf read arguments that aren't there ('%%' stays a literal '%')
+static bool isFramePattern(const std::string& pattern)
+{
+	int numConversions = 0;
+	for (size_t i = 0; i < pattern.size(); i++)
+	{
+		if (pattern[i] != '%')
+			continue;
+		if (i + 1 < pattern.size() && pattern[i + 1] == '%')
+		{
+			i++;
+			continue;
+		}
+		size_t j = i + 1;
+		while (j < pattern.size() && std::isdigit((unsigned char)pattern[j]))
+			j++;
+		if (j >= pattern.size() || pattern[j] != 'd')
+			return false;
+		numConversions++;
+		i = j;
+	}
+	return numConversions == 1;
+}
+
+FrameCapture::FrameCapture(const std::string& output, int maxQueuedFrames) : output(output), frames(maxQueuedFrames)
+{
+	if (!output.empty() && output[0] == '|')
+	{
+		// binary mode matters on Windows, where text pipes translate line endings
+#ifdef _WIN32
+		pipe = popen(output.c_str() + 1, "wb");
+#else
+		pipe = popen(output.c_str() + 1, "w");
+#endif
+	}
+	for (int i = maxQueuedFrames - 1; i >= 0; i--)
+		freeFrames.push_back(i);
+
+	TransientContextLock lock;
+	if (gl.load())
+	{
+		readbacks.resize(NUM_READBACKS);
+		for (Readback& readback : readbacks)
+			gl.genBuffers(1, &readback.buffer);
+	}
+	thread = std::thread(&FrameCapture::run, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	finish();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	condition.notify_all();
+	thread.join();
+	if (pipe)
+		pclose(pipe);
+	TransientContextLock lock;
+	for (Readback& readback : readbacks)
+		gl.deleteBuffers(1, &readback.buffer);
+}
+
+bool FrameCapture::isOpen()
+{
+	return output[0] == '|' ? pipe != nullptr : isFramePattern(output);
+}
+
+bool FrameCapture::push(const sf::Texture& texture)
+{
+	if (readbacks.empty())
+		return pushImage(texture.copyToImage());
+
+	TransientContextLock lock;
+	Readback& readback = readbacks[nextReadback];
+	nextReadback = (nextReadback + 1) % NUM_READBACKS;
+	// the copy into this buffer was started NUM_READBACKS pushes ago, so mapping it doesn't wait for the GPU
+	const bool kept = !readback.pending || collect(readback);
+
+	// glGetTexImage only queues the copy when a pixel buffer is bound
+	gl.bindBuffer(PIXEL_PACK_BUFFER, readback.buffer);
+	if (readback.size != texture.getSize())
+	{
+		readback.size = texture.getSize();
+		gl.bufferData(PIXEL_PACK_BUFFER, 4 * (std::ptrdiff_t)readback.size.x * readback.size.y, nullptr, STREAM_READ);
+	}
+	sf::Texture::bind(&texture);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	sf::Texture::bind(nullptr);
+	gl.bindBuffer(PIXEL_PACK_BUFFER, 0);
+	readback.pending = true;
+	return kept;
+}
+
+void FrameCapture::finish()
+{
+	{
+		// frames still in pixel buffers, oldest first
+		TransientContextLock lock;
+		for (int i = 0; i < (int)readbacks.size(); i++)
+		{
+			Readback& readback = readbacks[(nextReadback + i) % NUM_READBACKS];
+			if (readback.pending)
+				collect(readback);
+		}
+	}
+	std::unique_lock<std::mutex> lock(mutex);
+	condition.wait(lock, [this] { return freeFrames.size() == frames.size(); });
+	if (pipe)
+		fflush(pipe);
+}
+
+int FrameCapture::takeFrame()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	// the worker is too far behind, waiting for it would stall the main loop
+	if (freeFrames.empty())
+	{
+		numDropped++;
+		return -1;
+	}
+	const int slot = freeFrames.back();
+	freeFrames.pop_back();
+	return slot;
+}
+
+void FrameCapture::queueFrame(int slot)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// only kept frames are numbered, a gap would end the sequence for tools like ffmpeg
+		frames[slot].index = numQueued++;
+		queuedFrames.push_back(slot);
+	}
+	condition.notify_all();
+}
+
+bool FrameCapture::collect(Readback& readback)
+{
+	readback.pending = false;
+	const int slot = takeFrame();
+	if (slot < 0)
+		return false;
+	Frame& frame = frames[slot];
+	frame.size = readback.size;
+	frame.pixels.resize(4 * (size_t)frame.size.x * frame.size.y);
+
+	gl.bindBuffer(PIXEL_PACK_BUFFER, readback.buffer);
+	const sf::Uint8* pixels = static_cast<const sf::Uint8*>(gl.mapBuffer(PIXEL_PACK_BUFFER, READ_ONLY));
+	if (pixels)
+	{
+		// render targets store the bottom row first
+		const size_t rowSize = 4 * (size_t)frame.size.x;
+		for (unsigned int y = 0; y < frame.size.y; y++)
+			std::memcpy(&frame.pixels[y * rowSize], pixels + (frame.size.y - 1 - y) * rowSize, rowSize);
+		gl.unmapBuffer(PIXEL_PACK_BUFFER);
+	}
+	gl.bindBuffer(PIXEL_PACK_BUFFER, 0);
+
+	if (!pixels)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		freeFrames.push_back(slot);
+		numDropped++;
+		return false;
+	}
+	queueFrame(slot);
+	return true;
+}
+
+bool FrameCapture::pushImage(const sf::Image& image)
+{
+	const int slot = takeFrame();
+	if (slot < 0)
+		return false;
+	Frame& frame = frames[slot];
+	frame.size = image.getSize();
+	frame.pixels.resize(4 * (size_t)frame.size.x * frame.size.y);
+	std::memcpy(frame.pixels.data(), image.getPixelsPtr(), frame.pixels.size());
+	queueFrame(slot);
+	return true;
+}
+
+int FrameCapture::getNumWritten()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return numWritten;
+}
+
+int FrameCapture::getNumDropped()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return numDropped;
+}
+
+void FrameCapture::run()
+{
+	while (true)
+	{
+		int slot = 0;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return !queuedFrames.empty() || !running; });
+			if (queuedFrames.empty())
+				return;
+			slot = queuedFrames.front();
+			queuedFrames.pop_front();
+		}
+
+		write(frames[slot]);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			freeFrames.push_back(slot);
+			numWritten++;
+		}
+		condition.notify_all();
+	}
+}
+
+void FrameCapture::write(const Frame& frame)
+{
+	if (pipe)
+	{
+		fwrite(frame.pixels.data(), 1, frame.pixels.size(), pipe);
+		return;
+	}
+	if (output[0] == '|' || !isFramePattern(output))
+		return;
+	char fileName[512];
+	std::snprintf(fileName, sizeof(fileName), output.c_str(), frame.index);
+	sf::Image image;
+	image.create(frame.size.x, frame.size.y, frame.pixels.data());
+	image.saveToFile(fileName);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// write rendered frames on a worker thread so that encoding and disk or pipe output don't slow down the main loop
+// frames are either saved as numbered PNG files or written as raw RGBA to the standard input of a command, e.g.
+// |ffmpeg -f rawvideo -pixel_format rgba -video_size 1920x1080 -framerate 60 -i - replay.mp4
+// the readback goes through pixel buffers: a frame is copied on the GPU when it is pushed and only mapped
+// a few pushes later, when the copy is done (without pixel buffers the texture is copied to an image at once)
+class FrameCapture : sf::GlResource
+{
+public:
+	// output is a file name with one printf integer (capture/frame%05d.png) or a command after a '|',
+	// isOpen is false for any other pattern
+	// at most maxQueuedFrames frames wait for the worker, the next ones are dropped
+	FrameCapture(const std::string& output, int maxQueuedFrames = 4);
+	~FrameCapture();
+
+	bool isOpen();
+	// start reading the texture back and queue the frame read back earlier (returns false if that one was dropped)
+	// the texture has to belong to a render target or be updated from a window, their rows are stored bottom up
+	bool push(const sf::Texture& texture);
+	// wait until every pushed frame is written
+	void finish();
+	int getNumWritten();
+	// dropped frames aren't numbered, the written files stay a sequence without gaps
+	int getNumDropped();
+
+private:
+	struct Frame
+	{
+		sf::Vector2u size;
+		std::vector<sf::Uint8> pixels;
+		int index = 0;
+	};
+
+	// a pixel buffer the GPU copies a frame into
+	struct Readback
+	{
+		unsigned int buffer = 0;
+		sf::Vector2u size;
+		bool pending = false;
+	};
+
+	void run();
+	void write(const Frame& frame);
+	// free frame for the next pixels, -1 (and counted as dropped) if there is none
+	int takeFrame();
+	void queueFrame(int slot);
+	// map the pixel buffer and queue its frame
+	bool collect(Readback& readback);
+	bool pushImage(const sf::Image& image);
+
+	std::string output;
+	// raw frames go to this pipe when the output is a command
+	FILE* pipe = nullptr;
+	// empty when pixel buffers aren't supported, used round robin otherwise
+	std::vector<Readback> readbacks;
+	int nextReadback = 0;
+	// frames are reused so that capturing doesn't allocate once warmed up (unless it falls back to images)
+	std::vector<Frame> frames;
+	std::vector<int> freeFrames;
+	std::deque<int> queuedFrames;
+	int numQueued = 0;
+	int numWritten = 0;
+	int numDropped = 0;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool running = true;
+	std::thread thread;
+};
@@ -1,18 +1,38 @@
 #include "Game.hpp"
 #include <iostream>
 
-Game::Game(int width, int height, const std::string& title, int windowStyle = sf::Style::Default)
-	: windowWidth(width), windowHeight(height), window(sf::VideoMode(width, height), title, windowStyle),
-	eventManager(window, true), context(window)
-{
+Game::Game(int width, int height, const std::string& title, int windowStyle, bool headless)
+	: windowWidth(width), windowHeight(height), headless(headless),
+	eventManager(window, true), context(window, sf::Vector2u(width, height))
+{
+	if (headless)
+	{
+		offscreen[0].create(width, height);
+		offscreen[1].create(width, height);
+		context.setTarget(offscreen[currentFrame]);
+	}
+	else
+	{
+		window.create(sf::VideoMode(width, height), title, windowStyle);
+	}
 	addBasicEvents();
 }
 
+Game::~Game()
+{
+	close();
+}
+
 sf::RenderWindow& Game::getWindow()
 {
 	return window;
 }
 
+bool Game::isHeadless()
+{
+	return headless;
+}
+
 sfev::EventManager& Game::getEventManager()
 {
 	return eventManager;
@@ -25,7 +45,7 @@ RenderContext& Game::getRenderContext()
 
 bool Game::isRunning()
 {
-	return window.isOpen();
+	return headless ? running : window.isOpen();
 }
 
 void Game::handleEvents()
@@ -35,12 +55,67 @@ void Game::handleEvents()
 
 void Game::clear(sf::Color clearColor)
 {
-	window.clear(clearColor);
+	context.target->clear(clearColor);
 }
 
 void Game::display()
 {
-	window.display();
+	if (headless)
+	{
+		offscreen[currentFrame].display();
+	}
+	else
+	{
+		// copying the window stays on the GPU
+		if (capture)
+			windowFrames[currentFrame].update(window);
+		window.display();
+	}
+	// the previous frame is finished by now, reading the current one back would wait for the GPU
+	if (capture && numFrames > 0)
+		capture->push(getFrame(1 - currentFrame));
+	currentFrame = 1 - currentFrame;
+	numFrames++;
+	if (headless)
+		context.setTarget(offscreen[currentFrame]);
+}
+
+void Game::close()
+{
+	running = false;
+	if (window.isOpen())
+		window.close();
+	if (capture)
+	{
+		// the last frame wasn't read back yet
+		if (numFrames > 0)
+			capture->push(getFrame(1 - currentFrame));
+		capture.reset();
+	}
+}
+
+bool Game::startCapture(const std::string& output)
+{
+	capture = std::make_unique<FrameCapture>(output);
+	if (!capture->isOpen())
+	{
+		std::cerr << "can't capture to " << output << " (a command after '|' or a file name with one %d is needed)" << std::endl;
+		capture.reset();
+		return false;
+	}
+	if (!headless)
+	{
+		windowFrames[0].create(windowWidth, windowHeight);
+		windowFrames[1].create(windowWidth, windowHeight);
+	}
+	// frames drawn before don't have a copy
+	numFrames = 0;
+	return true;
+}
+
+const sf::Texture& Game::getFrame(int index)
+{
+	return headless ? offscreen[index].getTexture() : windowFrames[index];
 }
 
 void Game::setFramerate(int framerate)
@@ -51,15 +126,16 @@ void Game::setFramerate(int framerate)
 void Game::addBasicEvents()
 {
 	// close window
-	eventManager.addEventCallback(sf::Event::EventType::Closed, [&](const sf::Event& event) { window.close(); });
-	eventManager.addKeyPressedCallback(sf::Keyboard::Escape, [&](const sf::Event& event) { window.close(); });
+	eventManager.addEventCallback(sf::Event::EventType::Closed, [&](const sf::Event& event) { close(); });
+	eventManager.addKeyPressedCallback(sf::Keyboard::Escape, [&](const sf::Event& event) { close(); });
 
-	// update mouse position
+	// update mouse position (moves are merged by the event manager, so this runs about once per frame)
 	eventManager.addEventCallback(sf::Event::MouseMoved, [&](const sf::Event& event) {
-		context.stateManager.updateMousePosition(eventManager.getFloatMousePosition());
-		clickPosition = getWorldMousePosition();
+		context.stateManager.updateMousePosition({ (float)event.mouseMove.x, (float)event.mouseMove.y });
+		const sf::Vector2f worldPosition = getWorldMousePosition();
+		clickPosition = worldPosition;
 		prevDragPosition = dragPosition;
-		dragPosition = getWorldMousePosition();
+		dragPosition = worldPosition;
 		});
 }
 
@@ -3,13 +3,18 @@
 #include <string>
 #include "EventManager/event_manager.hpp"
 #include "RenderContext.hpp"
+#include "FrameCapture.hpp"
+#include <memory>
 
 class Game
 {
 public:
-	Game(int width, int height, const std::string& title, int windowStyle);
+	// a headless game doesn't open a window and draws into render textures instead
+	Game(int width, int height, const std::string& title, int windowStyle, bool headless = false);
+	~Game();
 
 	sf::RenderWindow& getWindow();
+	bool isHeadless();
 	sfev::EventManager& getEventManager();
 	RenderContext& getRenderContext();
 
@@ -18,6 +23,11 @@ public:
 	void handleEvents();
 	void clear(sf::Color clearColor = sf::Color::Black);
 	void display();
+	// stop the main loop (the window is closed and the capture finished)
+	void close();
+
+	// every displayed frame is also written to output (see FrameCapture)
+	bool startCapture(const std::string& output);
 
 	void setFramerate(int framerate);
 	void addBasicEvents();
@@ -38,8 +48,20 @@ private:
 	int windowWidth;
 	int windowHeight;
 
+	bool headless;
+	bool running = true;
 	sf::RenderWindow window;
+	// frames are drawn into these when headless, alternating every frame
+	sf::RenderTexture offscreen[2];
 	sfev::EventManager eventManager;
 	RenderContext context;
 
+	// the frame of the previous display is read back, so that it doesn't wait for the one just drawn
+	std::unique_ptr<FrameCapture> capture;
+	// copies of the window (the window itself can't be read back later)
+	sf::Texture windowFrames[2];
+	int currentFrame = 0;
+	int numFrames = 0;
+	const sf::Texture& getFrame(int index);
+
 };
\ No newline at end of file
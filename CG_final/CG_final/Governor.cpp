@@ -0,0 +1,123 @@
+#include "Governor.hpp"
+#include <algorithm>
+
+// weight of the current frame in the smoothed times
+constexpr float SMOOTHING = 0.1f;
+// frames to wait between two decisions
+constexpr int COOLDOWN_FRAMES = 30;
+// part of the target frame time used for physics and rendering (the rest is headroom)
+constexpr float BUDGET = 0.85f;
+// the load is only increased if the frame is this far under budget
+constexpr float RELAXED_BUDGET = 0.6f;
+// spawn scale change per decision
+constexpr float SPAWN_SCALE_STEP = 0.25f;
+
+Governor::Governor(float targetFrameTime, int minSubSteps, int maxSubSteps, int maxCollisionIterations)
+	:targetFrameTime(targetFrameTime), minSubSteps(minSubSteps), maxSubSteps(maxSubSteps),
+	maxCollisionIterations(maxCollisionIterations) {}
+
+void Governor::update(Solver& solver, float physicsTime, float renderTime)
+{
+	stats.physicsTime += SMOOTHING * (physicsTime - stats.physicsTime);
+	stats.renderTime += SMOOTHING * (renderTime - stats.renderTime);
+	stats.subSteps = solver.getSubSteps();
+	stats.collisionIterations = solver.getCollisionIterations();
+
+	if (cooldown > 0)
+	{
+		cooldown--;
+		return;
+	}
+
+	const float frameTime = overlapped ? std::max(stats.physicsTime, stats.renderTime) : stats.physicsTime + stats.renderTime;
+	stats.lastDecision = 0;
+	if (frameTime > BUDGET * targetFrameTime)
+	{
+		if (decreaseLoad(solver))
+			stats.lastDecision = -1;
+	}
+	else if (frameTime < RELAXED_BUDGET * targetFrameTime)
+	{
+		if (increaseLoad(solver))
+			stats.lastDecision = 1;
+	}
+
+	if (stats.lastDecision != 0)
+	{
+		cooldown = COOLDOWN_FRAMES;
+		stats.subSteps = solver.getSubSteps();
+		stats.collisionIterations = solver.getCollisionIterations();
+	}
+}
+
+void Governor::setOverlapped(bool isOverlapped)
+{
+	overlapped = isOverlapped;
+}
+
+bool Governor::decreaseLoad(Solver& solver)
+{
+	// the cheapest quality to give up first, then precision, then new objects
+	if (solver.getCollisionIterations() > 1)
+	{
+		solver.setCollisionIterations(solver.getCollisionIterations() - 1);
+		return true;
+	}
+	if (solver.getSubSteps() > minSubSteps)
+	{
+		solver.setSubSteps(std::max(solver.getSubSteps() - 2, minSubSteps));
+		return true;
+	}
+	if (stats.spawnScale > 0.0f)
+	{
+		stats.spawnScale = std::max(stats.spawnScale - SPAWN_SCALE_STEP, 0.0f);
+		return true;
+	}
+	return false;
+}
+
+bool Governor::increaseLoad(Solver& solver)
+{
+	// give things back in the opposite order, only if the predicted cost fits
+	if (stats.spawnScale < 1.0f)
+	{
+		stats.spawnScale = std::min(stats.spawnScale + SPAWN_SCALE_STEP, 1.0f);
+		return true;
+	}
+
+	const int subSteps = solver.getSubSteps();
+	const float stepTime = stats.physicsTime / subSteps;
+	if (subSteps < maxSubSteps)
+	{
+		const int newSubSteps = std::min(subSteps + 2, maxSubSteps);
+		if (stats.renderTime + stepTime * newSubSteps < BUDGET * targetFrameTime)
+		{
+			solver.setSubSteps(newSubSteps);
+			return true;
+		}
+		return false;
+	}
+
+	const int iterations = solver.getCollisionIterations();
+	if (iterations < maxCollisionIterations)
+	{
+		// collisions are most of a sub-step, so this is a pessimistic estimate
+		const float iterationTime = stats.physicsTime / iterations;
+		if (stats.renderTime + stats.physicsTime + iterationTime < BUDGET * targetFrameTime)
+		{
+			solver.setCollisionIterations(iterations + 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+float Governor::getSpawnScale()
+{
+	return stats.spawnScale;
+}
+
+const GovernorStats& Governor::getStats()
+{
+	return stats;
+}
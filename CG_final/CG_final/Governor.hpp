@@ -0,0 +1,45 @@
+#pragma once
+#include "Solver.hpp"
+
+// decisions taken by the governor (for statistics)
+struct GovernorStats
+{
+	// smoothed cost of one frame in seconds
+	float physicsTime = 0.0f;
+	float renderTime = 0.0f;
+	int subSteps = 0;
+	int collisionIterations = 0;
+	// how fast objects can be spawned (0: not at all, 1: normal rate)
+	float spawnScale = 1.0f;
+	// -1: decreased the load, 0: nothing, 1: increased the load (last decision)
+	int lastDecision = 0;
+};
+
+// adapt the work of the solver so that a frame fits in the target frame time
+class Governor
+{
+public:
+	Governor(float targetFrameTime, int minSubSteps, int maxSubSteps, int maxCollisionIterations = 1);
+
+	// measured times of the current frame (in seconds), the decisions are applied to the solver
+	void update(Solver& solver, float physicsTime, float renderTime);
+
+	// physics and rendering run at the same time, so a frame costs the longer of both
+	void setOverlapped(bool isOverlapped);
+
+	// spawning intervals should be divided by this (0 means no spawning)
+	float getSpawnScale();
+	const GovernorStats& getStats();
+
+private:
+	bool decreaseLoad(Solver& solver);
+	bool increaseLoad(Solver& solver);
+
+	float targetFrameTime;
+	int minSubSteps, maxSubSteps;
+	int maxCollisionIterations;
+	bool overlapped = false;
+	// frames to wait after a decision so that its effect can be measured
+	int cooldown = 0;
+	GovernorStats stats;
+};
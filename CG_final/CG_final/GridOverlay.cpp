@@ -0,0 +1,64 @@
+#include "GridOverlay.hpp"
+
+GridOverlay::GridOverlay(const CollisionGrid& grid) : numCols(grid.numCols)
+{
+	// a small gap between the quads shows the cell borders
+	const float gap = 0.3f;
+	const float size = (float)grid.cellSize;
+	vertices.resize(4 * grid.numRows * grid.numCols);
+	counts.assign(grid.numRows * grid.numCols, 0);
+	for (int row = 0; row < grid.numRows; row++)
+	{
+		for (int col = 0; col < grid.numCols; col++)
+		{
+			sf::Vertex* quad = &vertices[4 * (row * grid.numCols + col)];
+			const float left = col * size + gap;
+			const float top = row * size + gap;
+			const float right = (col + 1) * size - gap;
+			const float bottom = (row + 1) * size - gap;
+			const sf::Color color = getColor(0);
+			quad[0] = sf::Vertex({ left, top }, color);
+			quad[1] = sf::Vertex({ right, top }, color);
+			quad[2] = sf::Vertex({ right, bottom }, color);
+			quad[3] = sf::Vertex({ left, bottom }, color);
+		}
+	}
+}
+
+void GridOverlay::update(const RenderState& frame)
+{
+	if (frame.cellCounts.size() != counts.size())
+		return;
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		if (frame.cellCounts[i] == counts[i])
+			continue;
+		counts[i] = frame.cellCounts[i];
+		const sf::Color color = getColor(counts[i]);
+		for (int j = 0; j < 4; j++)
+			vertices[4 * i + j].color = color;
+	}
+}
+
+void GridOverlay::draw(RenderContext& context, sf::RenderStates& states, int firstRow, int lastRow)
+{
+	if (firstRow > lastRow)
+		return;
+	const size_t first = 4 * firstRow * numCols;
+	const size_t count = 4 * (lastRow - firstRow + 1) * numCols;
+	context.draw(&vertices[first], count, sf::Quads, states);
+}
+
+sf::Color GridOverlay::getColor(int count)
+{
+	if (count == 0)
+		return { 255, 255, 255, 12 };
+	// a full cell holds CELL_CAPACITY particles, the next ones are dropped and don't collide
+	if (count >= CELL_CAPACITY)
+		return { 255, 0, 255, 160 };
+	// from green for one particle to red for CELL_CAPACITY - 1 (one slot left)
+	const float t = (float)(count - 1) / (CELL_CAPACITY - 2);
+	if (t < 0.5f)
+		return { (sf::Uint8)(510 * t), 255, 0, 90 };
+	return { 255, (sf::Uint8)(510 * (1.0f - t)), 0, 90 };
+}
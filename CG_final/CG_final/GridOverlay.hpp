@@ -0,0 +1,29 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+#include "CollisionGrid.hpp"
+#include "RenderContext.hpp"
+#include "RenderState.hpp"
+
+// debug view of the collision grid, every cell is a quad coloured by how many particles it holds
+// quads are built once and only recoloured when the count of their cell changes
+class GridOverlay
+{
+public:
+	GridOverlay(const CollisionGrid& grid);
+
+	void update(const RenderState& frame);
+	// draw the rows [firstRow, lastRow] in one call
+	void draw(RenderContext& context, sf::RenderStates& states, int firstRow, int lastRow);
+
+	// heatmap colour of a cell (full cells drop particles, so they stand out)
+	static sf::Color getColor(int count);
+
+private:
+	int numCols;
+	// four vertices per cell, row major like the grid
+	std::vector<sf::Vertex> vertices;
+	// counts the colours were computed from
+	std::vector<uint8_t> counts;
+};
@@ -1,25 +1,23 @@
 #pragma once
 #include <SFML/Graphics.hpp>
-#include "ConstantIndexVector/index_vector.hpp"
 
 // basic object
+// only the data needed every sub-step is stored here (28 bytes), the id is known by the
+// IndexVector and mass and radius are kept by Solver in side arrays when they are not default
 struct Particle
 {
-	// use an id to identify an object
-	civ::ID id = 0;
 	sf::Vector2f currentPosition;
 	sf::Vector2f prevPosition;
-	float mass = 1.0f;
-	sf::Vector2f velocity;
 	sf::Vector2f acceleration;
-	float radius = 1.0f;
-	// whether the particle can move or not
+	// whether the particle can move or not (flags share the padding at the end)
 	bool pinned = false;
+	// whether the particle is simulated with fewer sub-steps (level of detail outside of the view)
+	bool coarse = false;
 
 	Particle() = default;
 
-	Particle(sf::Vector2f position, float radius, bool pinned = false)
-		:currentPosition(position), prevPosition(position), radius(radius), pinned(pinned) {}
+	Particle(sf::Vector2f position, bool pinned = false)
+		:currentPosition(position), prevPosition(position), pinned(pinned) {}
 
 	void initVelocity(const sf::Vector2f& v, float dt)
 	{
@@ -50,10 +48,10 @@ struct Particle
 		acceleration = { 0.0f, 0.0f };
 	}
 
-	void applyForce(const sf::Vector2f& force)
+	void applyForce(const sf::Vector2f& force, float inverseMass = 1.0f)
 	{
 		// F = m * a -> a = F / m
-		sf::Vector2f a = force / mass;
+		sf::Vector2f a = force * inverseMass;
 		acceleration += a;
 	}
 
@@ -0,0 +1,110 @@
+#include "ParticleRenderer.hpp"
+#include <algorithm>
+
+// GLSL 1.10 without extensions so that it also runs on software rasterizers
+// the texture coordinates are the corner of the quad (-1 to 1) and the red channel is the ramp value
+// (the ramp is the one of ColorRamp::get)
+static const char* vertexShader = R"(
+#version 110
+varying vec2 local;
+varying float value;
+void main()
+{
+	gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+	local = gl_MultiTexCoord0.xy;
+	value = gl_Color.r;
+}
+)";
+
+static const char* fragmentShader = R"(
+#version 110
+varying vec2 local;
+varying float value;
+uniform float useRamp;
+vec3 ramp(float t)
+{
+	return clamp(vec3(1.5 - abs(4.0 * t - 3.0), 1.5 - abs(4.0 * t - 2.0), 1.5 - abs(4.0 * t - 1.0)), 0.0, 1.0);
+}
+void main()
+{
+	float d = dot(local, local);
+	if (d > 1.0)
+		discard;
+	// smooth edge about one pixel wide
+	float alpha = 1.0 - smoothstep(1.0 - fwidth(d), 1.0, d);
+	vec3 color = mix(vec3(1.0), ramp(value), useRamp);
+	// shade it like a sphere
+	float light = 0.6 + 0.4 * sqrt(1.0 - d);
+	gl_FragColor = vec4(color * light, alpha);
+}
+)";
+
+ParticleRenderer::ParticleRenderer(const sf::Texture& fallbackTexture) : fallbackTexture(fallbackTexture), vertices(sf::Quads)
+{
+	useShader = sf::Shader::isAvailable() && shader.loadFromMemory(vertexShader, fragmentShader);
+}
+
+void ParticleRenderer::setColor(ParticleColor color)
+{
+	this->color = color;
+}
+
+ParticleColor ParticleRenderer::getColor()
+{
+	return color;
+}
+
+void ParticleRenderer::setMaxSpeed(float speed)
+{
+	maxSpeed = speed;
+}
+
+bool ParticleRenderer::isShaderAvailable()
+{
+	return useShader;
+}
+
+void ParticleRenderer::begin()
+{
+	// the vertex array keeps its memory, so this doesn't allocate once warmed up
+	vertices.clear();
+}
+
+void ParticleRenderer::add(const sf::Vector2f& position, float radius, float speed)
+{
+	const float value = color == ParticleColor::Speed ? std::min(speed / maxSpeed, 1.0f) : 0.0f;
+	const sf::Vector2f corners[4] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+	if (useShader)
+	{
+		const sf::Color vertexColor((sf::Uint8)(value * 255.0f), 0, 0);
+		for (const sf::Vector2f& corner : corners)
+			vertices.append(sf::Vertex(position + radius * corner, vertexColor, corner));
+	}
+	else
+	{
+		const sf::Color vertexColor = color == ParticleColor::Speed ? ColorRamp::get(value) : sf::Color::White;
+		const sf::Vector2f textureSize = (sf::Vector2f)fallbackTexture.getSize();
+		for (const sf::Vector2f& corner : corners)
+		{
+			const sf::Vector2f textureCoords(0.5f * (corner.x + 1.0f) * textureSize.x, 0.5f * (corner.y + 1.0f) * textureSize.y);
+			vertices.append(sf::Vertex(position + radius * corner, vertexColor, textureCoords));
+		}
+	}
+}
+
+void ParticleRenderer::draw(RenderContext& context, sf::RenderStates& states)
+{
+	if (vertices.getVertexCount() == 0)
+		return;
+	sf::RenderStates particleStates = states;
+	if (useShader)
+	{
+		shader.setUniform("useRamp", color == ParticleColor::Speed ? 1.0f : 0.0f);
+		particleStates.shader = &shader;
+	}
+	else
+	{
+		particleStates.texture = &fallbackTexture;
+	}
+	context.draw(vertices, particleStates);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include "RenderContext.hpp"
+#include "ColorRamp.hpp"
+
+// what the colour of a particle shows
+enum class ParticleColor
+{
+	Plain,
+	// blue when still, red at maxSpeed or more
+	Speed
+};
+
+// draw particles as quads that a shader turns into circles (computed per pixel, no texture fetch)
+// every particle carries a value that is mapped to a colour ramp, all of them are drawn in one call
+// without shader support the quads are textured with the circle texture and coloured on the CPU
+class ParticleRenderer
+{
+public:
+	ParticleRenderer(const sf::Texture& fallbackTexture);
+
+	void setColor(ParticleColor color);
+	ParticleColor getColor();
+	void setMaxSpeed(float speed);
+	bool isShaderAvailable();
+
+	// collect the particles of a frame between begin and draw
+	void begin();
+	void add(const sf::Vector2f& position, float radius, float speed);
+	void draw(RenderContext& context, sf::RenderStates& states);
+
+private:
+	const sf::Texture& fallbackTexture;
+	sf::Shader shader;
+	bool useShader = false;
+	ParticleColor color = ParticleColor::Plain;
+	float maxSpeed = 1000.0f;
+	// four vertices per particle
+	sf::VertexArray vertices;
+};
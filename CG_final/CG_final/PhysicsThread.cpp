@@ -0,0 +1,101 @@
+#include "PhysicsThread.hpp"
+
+PhysicsThread::PhysicsThread(Solver& solver) : solver(solver)
+{
+	solver.writeRenderState(buffers[front]);
+	thread = std::thread(&PhysicsThread::run, this);
+}
+
+PhysicsThread::~PhysicsThread()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	condition.notify_all();
+	thread.join();
+}
+
+void PhysicsThread::pushCommand(const Command& command)
+{
+	staged.push_back(command);
+}
+
+void PhysicsThread::pushStrip(const std::vector<sf::Vector2f>& points, bool pinEnds)
+{
+	staged.push_back(Command::spawnStrip((int)stagedStripPoints.size(), (int)points.size(), pinEnds));
+	stagedStripPoints.insert(stagedStripPoints.end(), points.begin(), points.end());
+}
+
+void PhysicsThread::start(bool pause)
+{
+	if (started)
+		return;
+	// the physics thread is idle, so the frame the commands land in doesn't depend on its timing
+	for (const Command& command : staged)
+	{
+		if (command.type == CommandType::SpawnStrip)
+			solver.pushStrip(stagedStripPoints.data() + command.first, command.count, command.pinned);
+		else
+			solver.pushCommand(command);
+	}
+	staged.clear();
+	stagedStripPoints.clear();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		paused = pause;
+		working = true;
+	}
+	started = true;
+	condition.notify_all();
+}
+
+void PhysicsThread::wait()
+{
+	if (!started)
+		return;
+	std::unique_lock<std::mutex> lock(mutex);
+	condition.wait(lock, [this] { return !working; });
+	front = 1 - front;
+	started = false;
+}
+
+const RenderState& PhysicsThread::getRenderState()
+{
+	return buffers[front];
+}
+
+const float PhysicsThread::getStepTime()
+{
+	return stepTime;
+}
+
+void PhysicsThread::run()
+{
+	sf::Clock clock;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return working || !running; });
+			if (!running)
+				return;
+		}
+
+		clock.restart();
+		if (!paused)
+			solver.update();
+		else
+			solver.applyCommands();
+		stepTime = clock.getElapsedTime().asSeconds();
+		// the front buffer may still be drawn, so only the back one is written
+		solver.writeRenderState(buffers[1 - front]);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			working = false;
+		}
+		condition.notify_all();
+	}
+}
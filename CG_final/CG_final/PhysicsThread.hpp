@@ -0,0 +1,52 @@
+#pragma once
+#include <SFML/System.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include "Solver.hpp"
+#include "RenderState.hpp"
+
+// run the solver on its own thread so that a frame is simulated while the previous one is rendered
+// (the solver must only be accessed through the staged commands, or between wait and start)
+class PhysicsThread
+{
+public:
+	PhysicsThread(Solver& solver);
+	~PhysicsThread();
+
+	// stage a command on the main thread, it is handed to the solver when the next frame is started
+	// (so every command is applied on the frame following the one that was running when it was pushed)
+	void pushCommand(const Command& command);
+	// stage a strip the same way, its points are copied
+	void pushStrip(const std::vector<sf::Vector2f>& points, bool pinEnds);
+	// start the next frame, staged commands are applied even when paused
+	void start(bool pause);
+	// wait for the frame to be finished and make its render state the front one
+	void wait();
+	// render state of the last finished frame (valid until the next wait)
+	const RenderState& getRenderState();
+	// time spent in the last frame (in seconds)
+	const float getStepTime();
+
+private:
+	void run();
+
+	Solver& solver;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool working = false;
+	bool running = true;
+	bool paused = false;
+	// whether a frame was started and not waited for yet (only used by the main thread)
+	bool started = false;
+	// commands pushed since the last start (only used by the main thread)
+	std::vector<Command> staged;
+	// points of the staged strips, their commands point into it
+	std::vector<sf::Vector2f> stagedStripPoints;
+	// the renderer reads the front buffer while the physics thread writes the back one
+	RenderState buffers[2];
+	int front = 0;
+	float stepTime = 0.0f;
+	std::thread thread;
+};
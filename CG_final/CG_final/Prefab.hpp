@@ -0,0 +1,194 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include "Math.hpp"
+
+// compound body defined once in local coordinates and instantiated many times by Solver
+struct Prefab
+{
+	struct Link
+	{
+		int p1, p2;
+		// rest length (computed once from the offsets)
+		float length;
+		float compliance;
+		bool collidable;
+	};
+
+	// particles relative to the origin of the body
+	std::vector<sf::Vector2f> offsets;
+	std::vector<bool> pinMask;
+	std::vector<Link> links;
+	// whether the whole body is kept in shape by a single shape matching constraint
+	bool rigid = false;
+	float rigidCompliance = 0.0f;
+	// closed ring of particles whose enclosed area is kept by a single area constraint
+	std::vector<int> ring;
+	float ringCompliance = 0.0f;
+	float ringPressure = 1.0f;
+
+	int addParticle(const sf::Vector2f& offset, bool pinned = false)
+	{
+		offsets.push_back(offset);
+		pinMask.push_back(pinned);
+		return (int)offsets.size() - 1;
+	}
+
+	void addLink(int p1, int p2, float compliance = 0.0f, bool collidable = false)
+	{
+		links.push_back({ p1, p2, Math::getDistance(offsets[p1], offsets[p2]), compliance, collidable });
+	}
+
+	int getNumParticles() const
+	{
+		return (int)offsets.size();
+	}
+
+	void clear()
+	{
+		offsets.clear();
+		pinMask.clear();
+		links.clear();
+		rigid = false;
+		rigidCompliance = 0.0f;
+		ring.clear();
+		ringCompliance = 0.0f;
+		ringPressure = 1.0f;
+	}
+
+	// load a prefab from a text file, every line is one of:
+	//   p x y [pinned]                  particle at local position (x, y), pinned is 0 or 1
+	//   l i j [compliance] [collidable] link between the i-th and the j-th particles
+	//   r [compliance]                  keep the whole body rigid with shape matching
+	//   a compliance pressure i j k ... keep the area of the ring made of the i-th, j-th, k-th... particles
+	// empty lines and lines starting with # are ignored
+	bool loadFromFile(const std::string& filename)
+	{
+		std::ifstream file(filename);
+		if (!file)
+		{
+			std::cerr << "Failed to load prefab \"" << filename << "\"" << std::endl;
+			return false;
+		}
+
+		clear();
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(file, line))
+		{
+			lineNumber++;
+			std::istringstream stream(line);
+			std::string type;
+			if (!(stream >> type) || type[0] == '#')
+				continue;
+
+			bool valid = false;
+			if (type == "p")
+			{
+				sf::Vector2f offset;
+				int pinned = 0;
+				valid = (bool)(stream >> offset.x >> offset.y);
+				stream >> pinned;
+				if (valid)
+					addParticle(offset, pinned != 0);
+			}
+			else if (type == "l")
+			{
+				int p1 = -1, p2 = -1, collidable = 0;
+				float compliance = 0.0f;
+				valid = (bool)(stream >> p1 >> p2);
+				stream >> compliance >> collidable;
+				valid = valid && p1 >= 0 && p2 >= 0 && p1 < getNumParticles() && p2 < getNumParticles();
+				if (valid)
+					addLink(p1, p2, compliance, collidable != 0);
+			}
+			else if (type == "r")
+			{
+				valid = true;
+				rigid = true;
+				stream >> rigidCompliance;
+			}
+			else if (type == "a")
+			{
+				int index = 0;
+				valid = (bool)(stream >> ringCompliance >> ringPressure);
+				while (valid && stream >> index)
+				{
+					valid = index >= 0 && index < getNumParticles();
+					ring.push_back(index);
+				}
+				valid = valid && ring.size() >= 3;
+			}
+
+			if (!valid)
+			{
+				std::cerr << "Failed to load prefab \"" << filename << "\" (invalid line " << lineNumber << ")" << std::endl;
+				clear();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 3x3 particles kept in shape by shape matching (rigid) or constraints at every edge and diagonal
+	static Prefab makeCube(float spacing, float compliance = 0.0f, bool rigid = true)
+	{
+		Prefab cube;
+		for (int row = -1; row <= 1; row++)
+		{
+			for (int col = -1; col <= 1; col++)
+			{
+				cube.addParticle({ col * spacing, row * spacing });
+			}
+		}
+		if (rigid)
+		{
+			cube.rigid = true;
+			cube.rigidCompliance = compliance;
+			return cube;
+		}
+
+		// edges
+		const int edges[12][2] = { {0, 1}, {1, 2}, {0, 3}, {1, 4}, {2, 5}, {3, 4}, {4, 5}, {3, 6}, {4, 7}, {5, 8}, {6, 7}, {7, 8} };
+		for (const auto& edge : edges)
+		{
+			cube.addLink(edge[0], edge[1], compliance);
+		}
+		// main diagonal
+		const int diagonals[4][2] = { {0, 4}, {1, 5}, {3, 7}, {4, 8} };
+		for (const auto& diagonal : diagonals)
+		{
+			cube.addLink(diagonal[0], diagonal[1], compliance);
+		}
+		return cube;
+	}
+
+	// a ring of numParticles particles linked to their neighbors that keeps its area with one constraint
+	// (a pinned center linked to the ring is only added with pinCenter, to make wheels on an axle)
+	static Prefab makeCircle(float radius, int numParticles, float compliance = 0.0f, bool pinCenter = false, bool pinOuter = false)
+	{
+		Prefab circle;
+		// small angle for every particle (2 * pi / numParticles)
+		const float delta = 2.0f * Math::PI / float(numParticles);
+		const int center = pinCenter ? circle.addParticle({ 0.0f, 0.0f }, true) : -1;
+		for (int i = 0; i < numParticles; i++)
+		{
+			int particle = circle.addParticle({ radius * std::cos(i * delta), radius * std::sin(i * delta) }, pinOuter);
+			circle.ring.push_back(particle);
+			if (pinCenter)
+				circle.addLink(particle, center, compliance);
+		}
+
+		// connect every outer particle with its adjacent particle
+		for (int i = 0; i < numParticles; i++)
+		{
+			circle.addLink(circle.ring[i], circle.ring[(i + 1) % numParticles], compliance);
+		}
+		circle.ringCompliance = compliance;
+		return circle;
+	}
+};
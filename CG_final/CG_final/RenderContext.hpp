@@ -5,19 +5,37 @@
 // this idea is from https://github.com/johnBuffer/VerletSFML-Multithread
 
 // this struct is the real one that doing drawing and transformation
+// the target is a window or a render texture (headless), both have to be of the given size
 struct RenderContext
 {
-	sf::RenderWindow& window;
+	sf::RenderTarget* target;
 	StateManager stateManager;
 
-	RenderContext(sf::RenderWindow& window)
-		:window(window), stateManager((sf::Vector2f)window.getSize()) {}
+	RenderContext(sf::RenderTarget& target, const sf::Vector2u& size)
+		:target(&target), stateManager((sf::Vector2f)size) {}
+
+	void setTarget(sf::RenderTarget& target)
+	{
+		this->target = &target;
+	}
 
 	void draw(sf::Drawable& drawable, sf::RenderStates states)
 	{
 		// apply transform
 		states.transform = stateManager.getTransform();
-		window.draw(drawable, states);
+		target->draw(drawable, states);
+	}
+
+	void draw(const sf::Vertex* vertices, size_t count, sf::PrimitiveType type, sf::RenderStates states)
+	{
+		states.transform = stateManager.getTransform();
+		target->draw(vertices, count, type, states);
+	}
+
+	// in screen pixels, for overlays that don't move with the view
+	void drawOnScreen(const sf::Vertex* vertices, size_t count, sf::PrimitiveType type)
+	{
+		target->draw(vertices, count, type);
 	}
 
 	void setFocus(const sf::Vector2f& focus)
@@ -0,0 +1,61 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+#include "SolverStats.hpp"
+
+// copy of what the renderer needs from one frame of the simulation
+// (written by the physics thread, never changed while it is being drawn)
+struct RenderState
+{
+	// particles are grouped by the cell of the collision grid they are in (row major),
+	// the ones of cell i are [particleStarts[i], particleStarts[i + 1])
+	std::vector<sf::Vector2f> positions;
+	std::vector<float> radii;
+	// in world units per second
+	std::vector<float> speeds;
+	std::vector<int> particleStarts;
+	float maxRadius = 0.0f;
+	// two end points per link (links that are part of a chain are not included)
+	// grouped by the cell of their middle point like the particles
+	std::vector<sf::Vector2f> links;
+	std::vector<float> linkStrains;
+	std::vector<int> linkStarts;
+	float maxLinkLength = 0.0f;
+	// particle positions of every chain, chain i is [chainStarts[i], chainStarts[i + 1])
+	// (a closed chain repeats its first point at the end)
+	std::vector<sf::Vector2f> chainPoints;
+	// average strain of the links next to each chain point
+	std::vector<float> chainStrains;
+	std::vector<int> chainStarts;
+	// outline of every shape-matched body, body i is [outlineStarts[i], outlineStarts[i + 1])
+	// (closed like the chains, the first point is repeated at the end)
+	std::vector<sf::Vector2f> outlinePoints;
+	std::vector<int> outlineStarts;
+	// largest absolute strain of every structure (links connected to each other) since the links last changed
+	std::vector<float> structureMaxStrains;
+	// number of particles in each cell of the collision grid (row major)
+	std::vector<uint8_t> cellCounts;
+	// counters and timings of the frame
+	SolverStats stats;
+
+	void clear()
+	{
+		positions.clear();
+		radii.clear();
+		speeds.clear();
+		particleStarts.clear();
+		maxRadius = 0.0f;
+		links.clear();
+		linkStrains.clear();
+		linkStarts.clear();
+		maxLinkLength = 0.0f;
+		chainPoints.clear();
+		chainStrains.clear();
+		chainStarts.clear();
+		outlinePoints.clear();
+		outlineStarts.clear();
+		structureMaxStrains.clear();
+		cellCounts.clear();
+	}
+};
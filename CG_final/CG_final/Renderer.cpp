@@ -1,6 +1,6 @@
 #include "Renderer.hpp"
 
-Renderer::Renderer(Solver& solver) : solver(solver), worldBox(sf::Quads, 4)
+Renderer::Renderer(Solver& solver) : solver(solver), worldBox(sf::Quads, 4), chains(2.0f, 2), gridOverlay(solver.getGrid()), particles(texture)
 {
 	initWorldBox();
 
@@ -27,82 +27,96 @@ void Renderer::initWorldBox()
 	worldBox[3] = sf::Vertex({ 0.0f, worldInfo.y }, worldBoxColor, { 0.0f, textureSize.y });
 }
 
-void Renderer::render(RenderContext& context, const sf::Vector2f& mousePosition, int type, bool showGrid)
+void Renderer::render(RenderContext& context, const RenderState& frame, const sf::Vector2f& mousePosition, int type, bool showGrid)
 {
 	// render state to store transform and texture
 	sf::RenderStates states;
+	// part of the world that is on the screen
+	const sf::FloatRect area = context.stateManager.getVisibleArea();
 
 	// draw world box
 	context.draw(worldBox, states);
 	// draw particles
-	drawParticles(context, states);
+	drawParticles(context, states, frame, area);
 	// draw links
-	drawConstraints(context, states);
+	drawConstraints(context, states, frame, area);
 	// draw collision grid
 	if (showGrid)
-		drawGrid(context, states);
+		drawGrid(context, states, frame, area);
 	// draw object type
 	//drawType(context, states, mousePosition, type);
 }
 
-void Renderer::drawParticles(RenderContext& context, sf::RenderStates& states)
+void Renderer::drawParticles(RenderContext& context, sf::RenderStates& states, const RenderState& frame, const sf::FloatRect& area)
 {
-	const sf::Vector2i textureSize = (sf::Vector2i)texture.getSize();
-	// draw a cirlce to represent an object
-	sf::CircleShape circle(1.0f);
-	//circle.setPointCount(32);
-	circle.setOrigin(1.0f, 1.0f);
-	circle.setTextureRect({ 0, 0, textureSize.x, textureSize.y });
-	circle.setTexture(&texture);
-	const civ::IndexVector<Particle>& particles = solver.getParticles();
-	for (const Particle& particle : particles)
+	// a particle can reach out of its cell by its radius
+	const sf::IntRect cells = getVisibleCells(area, frame.maxRadius);
+	const int numCols = solver.getGrid().numCols;
+	particles.begin();
+	for (int row = cells.top; row < cells.top + cells.height; row++)
 	{
-		circle.setPosition(particle.currentPosition);
-		circle.setScale(particle.radius, particle.radius);
-		context.draw(circle, states);
+		// particles of consecutive cells in a row are next to each other
+		const int first = frame.particleStarts[row * numCols + cells.left];
+		const int last = frame.particleStarts[row * numCols + cells.left + cells.width];
+		for (int i = first; i < last; i++)
+		{
+			particles.add(frame.positions[i], frame.radii[i], frame.speeds[i]);
+		}
 	}
+	particles.draw(context, states);
 }
 
-void Renderer::drawConstraints(RenderContext& context, sf::RenderStates& states)
+void Renderer::drawConstraints(RenderContext& context, sf::RenderStates& states, const RenderState& frame, const sf::FloatRect& area)
 {
-	// vertex array of links (draw with line)
-	const civ::IndexVector<Constraint>& constraints = solver.getConstraints();
 	// width of line
 	const float width = 2.0f;
+	// vertex array of links (draw with line)
 	sf::VertexArray linkVertices(sf::Quads);
-	for (int i = 0; i < constraints.size(); i++)
+	// links are grouped by their middle point, so they can reach out of its cell by half their length
+	const sf::IntRect cells = getVisibleCells(area, 0.5f * frame.maxLinkLength + width);
+	const int numCols = solver.getGrid().numCols;
+	for (int row = cells.top; row < cells.top + cells.height; row++)
 	{
-		const Constraint& constraint = constraints[i];
-		drawThickLine(linkVertices, constraint.p1->currentPosition, constraint.p2->currentPosition, width, sf::Color::Red);
+		const int first = frame.linkStarts[row * numCols + cells.left];
+		const int last = frame.linkStarts[row * numCols + cells.left + cells.width];
+		for (int i = first; i < last; i++)
+		{
+			const sf::Color color = showStrain ? ColorRamp::getStrain(frame.linkStrains[i], strainRange) : sf::Color::Red;
+			drawThickLine(linkVertices, frame.links[2 * i], frame.links[2 * i + 1], width, color);
+		}
 	}
-	context.draw(linkVertices, states);
-}
-
-void Renderer::drawGrid(RenderContext& context, sf::RenderStates& states)
-{
-	CollisionGrid& grid = solver.getGrid();
-	int cellSize = grid.cellSize;
-	// draw a rectangle to represent a cell
-	sf::RectangleShape rect({ (float)cellSize, (float)cellSize });
-	rect.setFillColor(sf::Color::Transparent);
-	rect.setOutlineThickness(0.3f);
-	for (int row = 0; row < grid.numRows; row++)
+	// outlines of shape-matched bodies, which don't have links
+	const sf::Color outlineColor = showStrain ? ColorRamp::getStrain(0.0f, strainRange) : sf::Color::Red;
+	for (int b = 0; b + 1 < (int)frame.outlineStarts.size(); b++)
 	{
-		for (int col = 0; col < grid.numCols; col++)
+		const int first = frame.outlineStarts[b];
+		const int last = frame.outlineStarts[b + 1];
+		sf::Vector2f min = frame.outlinePoints[first];
+		sf::Vector2f max = min;
+		for (int i = first + 1; i < last; i++)
 		{
-			rect.setPosition(col * cellSize, row * cellSize);
-			// if there are objects inside the cell, turn its outline color to green
-			if (grid.getCell(row, col).numObjects > 0)
-			{
-				rect.setOutlineColor(sf::Color::Green);
-			}
-			else
-			{
-				rect.setOutlineColor(sf::Color::Red);
-			}
-			context.draw(rect, states);
+			min = { std::min(min.x, frame.outlinePoints[i].x), std::min(min.y, frame.outlinePoints[i].y) };
+			max = { std::max(max.x, frame.outlinePoints[i].x), std::max(max.y, frame.outlinePoints[i].y) };
 		}
+		const sf::FloatRect bounds(min.x - width, min.y - width, max.x - min.x + 2.0f * width, max.y - min.y + 2.0f * width);
+		if (!bounds.intersects(area))
+			continue;
+		for (int i = first; i + 1 < last; i++)
+			drawThickLine(linkVertices, frame.outlinePoints[i], frame.outlinePoints[i + 1], width, outlineColor);
 	}
+	context.draw(linkVertices, states);
+	// chains are drawn as smooth strips instead of one line per link
+	chains.setStrainRange(showStrain ? strainRange : 0.0f);
+	chains.update(frame, area);
+	chains.draw(context, states);
+}
+
+void Renderer::drawGrid(RenderContext& context, sf::RenderStates& states, const RenderState& frame, const sf::FloatRect& area)
+{
+	// only the colours of cells whose count changed are updated, and the visible rows are drawn at once
+	gridOverlay.update(frame);
+	const sf::IntRect cells = getVisibleCells(area, 0.0f);
+	gridOverlay.draw(context, states, cells.top, cells.top + cells.height - 1);
 }
 
 void Renderer::drawType(RenderContext& context, sf::RenderStates& states, const sf::Vector2f& position, int type)
@@ -129,6 +143,43 @@ void Renderer::drawType(RenderContext& context, sf::RenderStates& states, const
 	context.draw(va, states);
 }
 
+sf::IntRect Renderer::getVisibleCells(const sf::FloatRect& area, float margin)
+{
+	const CollisionGrid& grid = solver.getGrid();
+	// objects outside of the world are stored in the border cells, so the range is clamped instead of being emptied
+	auto clamp = [](int value, int max) { return value < 0 ? 0 : value > max ? max : value; };
+	const int left = clamp((int)std::floor((area.left - margin) / grid.cellSize), grid.numCols - 1);
+	const int top = clamp((int)std::floor((area.top - margin) / grid.cellSize), grid.numRows - 1);
+	const int right = clamp((int)std::floor((area.left + area.width + margin) / grid.cellSize), grid.numCols - 1);
+	const int bottom = clamp((int)std::floor((area.top + area.height + margin) / grid.cellSize), grid.numRows - 1);
+	return { left, top, right - left + 1, bottom - top + 1 };
+}
+
+void Renderer::setParticleColor(ParticleColor color)
+{
+	particles.setColor(color);
+}
+
+ParticleColor Renderer::getParticleColor()
+{
+	return particles.getColor();
+}
+
+void Renderer::setShowStrain(bool show)
+{
+	showStrain = show;
+}
+
+bool Renderer::isShowingStrain()
+{
+	return showStrain;
+}
+
+void Renderer::setStrainRange(float range)
+{
+	strainRange = range;
+}
+
 // because SFML doesn't have line with width, draw a rectangle instead
 void Renderer::drawThickLine(sf::VertexArray& va, const sf::Vector2f& start, const sf::Vector2f& end, float width, sf::Color color)
 {
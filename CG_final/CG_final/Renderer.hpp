@@ -2,6 +2,10 @@
 #include <SFML/Graphics.hpp>
 #include "Solver.hpp"
 #include "RenderContext.hpp"
+#include "RenderState.hpp"
+#include "ChainRenderer.hpp"
+#include "GridOverlay.hpp"
+#include "ParticleRenderer.hpp"
 
 class Renderer
 {
@@ -10,22 +14,43 @@ public:
 
 	void initWorldBox();
 
-	void render(RenderContext& context, const sf::Vector2f& mousePosition, int type, bool showGrid);
+	// draw a frame of the simulation (the solver is only used for the world and grid sizes)
+	// only what intersects the visible area of the context is drawn
+	void render(RenderContext& context, const RenderState& frame, const sf::Vector2f& mousePosition, int type, bool showGrid);
 
-	void drawParticles(RenderContext& context, sf::RenderStates& states);
-	void drawConstraints(RenderContext& context, sf::RenderStates& states);
-	void drawGrid(RenderContext& context, sf::RenderStates& states);
+	void drawParticles(RenderContext& context, sf::RenderStates& states, const RenderState& frame, const sf::FloatRect& area);
+	void drawConstraints(RenderContext& context, sf::RenderStates& states, const RenderState& frame, const sf::FloatRect& area);
+	void drawGrid(RenderContext& context, sf::RenderStates& states, const RenderState& frame, const sf::FloatRect& area);
 	void drawType(RenderContext& context, sf::RenderStates& states, const sf::Vector2f& position, int type);
 	void drawThickLine(sf::VertexArray& va, const sf::Vector2f& start, const sf::Vector2f& end, float width, sf::Color color);
 
+	void setParticleColor(ParticleColor color);
+	ParticleColor getParticleColor();
+	// colour links by their strain instead of plain red
+	void setShowStrain(bool show);
+	bool isShowingStrain();
+	// strain drawn with the full colour (blue when compressed, red when stretched)
+	void setStrainRange(float range);
+
 private:
+	// cells of the collision grid (left and top are the first column and row) that intersect the area grown by margin
+	sf::IntRect getVisibleCells(const sf::FloatRect& area, float margin);
+
 	// physics solver
 	Solver& solver;
 	// vertex array of world box (draw with triangle strip)
 	sf::VertexArray worldBox;
+	// smooth strips of the chains
+	ChainRenderer chains;
+	// occupancy of the collision grid
+	GridOverlay gridOverlay;
 	// texture
 	sf::Texture texture;
 	// current type of object to build
 	sf::Texture particleTexture;
 	sf::Texture cubeTexture;
+	// particles of all visible cells (declared after the texture it falls back to)
+	ParticleRenderer particles;
+	bool showStrain = false;
+	float strainRange = 0.05f;
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+#include <cmath>
+#include <utility>
+#include "BodyStorage.hpp"
+#include "Math.hpp"
+
+// keep a group of particles in its rest shape by finding the best rigid transform
+// (shape matching) every step and pulling the particles toward it
+// every particle is solved like an XPBD distance constraint of length 0 to its goal position
+struct ShapeConstraint
+{
+	// range of the particles and their rest offsets (relative to the rest centroid) in the body storage
+	int first = 0;
+	int count = 0;
+	// compliance of the constraint (inverse of stiffness, 0 means rigid)
+	float compliance = 0.0f;
+	// the first outlineCount particles of the range are the outline in order of angle (it has no links to draw)
+	int outlineCount = 0;
+
+	ShapeConstraint() = default;
+	// the current positions of the particles are the rest shape
+	ShapeConstraint(BodyStorage& bodies, const civ::Ref<Particle>* refs, int count, float compliance)
+		:first(bodies.add(refs, count)), count(count), compliance(compliance)
+	{
+		const sf::Vector2f center = getCenter(bodies);
+		float maxLength = 0.0f;
+		for (int i = first; i < first + count; i++)
+		{
+			bodies.vectors[i] = bodies.particles[i]->currentPosition - center;
+			maxLength = std::max(maxLength, Math::getLength(bodies.vectors[i]));
+		}
+
+		// particles at least half as far from the center as the farthest one are on the outline
+		// (the order of the range doesn't matter to the solver, so it is sorted in place with an insertion sort)
+		auto isOutline = [&](int i) { return Math::getLength(bodies.vectors[i]) >= 0.5f * maxLength; };
+		auto getAngle = [&](int i) { return std::atan2(bodies.vectors[i].y, bodies.vectors[i].x); };
+		auto isBefore = [&](int a, int b)
+		{
+			if (isOutline(a) != isOutline(b))
+				return isOutline(a);
+			return isOutline(a) && getAngle(a) < getAngle(b);
+		};
+		for (int i = first + 1; i < first + count; i++)
+		{
+			for (int j = i; j > first && isBefore(j, j - 1); j--)
+			{
+				std::swap(bodies.particles[j], bodies.particles[j - 1]);
+				std::swap(bodies.vectors[j], bodies.vectors[j - 1]);
+			}
+		}
+		while (outlineCount < count && isOutline(first + outlineCount))
+			outlineCount++;
+	}
+
+	bool isValid(const BodyStorage& bodies)
+	{
+		for (int i = first; i < first + count; i++)
+		{
+			if (!bodies.particles[i])
+				return false;
+		}
+		return count > 0;
+	}
+
+	sf::Vector2f getCenter(BodyStorage& bodies)
+	{
+		sf::Vector2f center;
+		for (int i = first; i < first + count; i++)
+		{
+			center += bodies.particles[i]->currentPosition;
+		}
+		return center / (float)count;
+	}
+
+	// solve the constraint once, getInverseMass gives the inverse mass of a particle
+	template<typename TInverseMass>
+	void update(float dt, BodyStorage& bodies, TInverseMass&& getInverseMass)
+	{
+		if (!isValid(bodies))
+			return;
+
+		// in 2D the best rotation is the angle that maximizes sum(dot(R * q, p)),
+		// where q are the rest offsets and p the current offsets from the centroid
+		const sf::Vector2f center = getCenter(bodies);
+		float dot = 0.0f;
+		float cross = 0.0f;
+		for (int i = first; i < first + count; i++)
+		{
+			const sf::Vector2f p = bodies.particles[i]->currentPosition - center;
+			const sf::Vector2f& q = bodies.vectors[i];
+			dot += q.x * p.x + q.y * p.y;
+			cross += q.x * p.y - q.y * p.x;
+		}
+		const float angle = std::atan2(cross, dot);
+		const float cosAngle = std::cos(angle);
+		const float sinAngle = std::sin(angle);
+
+		// same scaling of compliance by time step as distance constraints, the multipliers are accumulated
+		// over the iterations of a sub-step, so the stiffness doesn't depend on the number of iterations
+		const float alpha = compliance / (dt * dt);
+		for (int i = first; i < first + count; i++)
+		{
+			const sf::Vector2f& q = bodies.vectors[i];
+			const sf::Vector2f goal = center + sf::Vector2f(q.x * cosAngle - q.y * sinAngle, q.x * sinAngle + q.y * cosAngle);
+			Particle& particle = *bodies.particles[i];
+			const float w = getInverseMass(particle);
+			const sf::Vector2f direction = particle.currentPosition - goal;
+			const float distance = Math::getLength(direction);
+			if (w + alpha == 0.0f || distance == 0.0f)
+				continue;
+			const float deltaLambda = (-distance - alpha * bodies.lambdas[i]) / (w + alpha);
+			bodies.lambdas[i] += deltaLambda;
+			particle.move(direction / distance * (w * deltaLambda));
+		}
+	}
+};
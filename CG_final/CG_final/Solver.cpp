@@ -1,30 +1,71 @@
 #include "Solver.hpp"
 #include "Math.hpp"
 #include <iostream>
+#include <algorithm>
 
 Solver::Solver(sf::Vector2f size, float particleRadius, int cellSize)
-	:worldSize(size), particleRadius(particleRadius), grid(size.x, size.y, cellSize) {}
+	:cubePrefab(Prefab::makeCube(2 * particleRadius)), worldSize(size), particleRadius(particleRadius),
+	grid(size.x, size.y, cellSize), activeArea({ 0.0f, 0.0f }, size) {}
 
 void Solver::update()
 {
+	stats = SolverStats();
+	phaseClock.restart();
+	applyCommands();
+	endPhase(SolverPhase::Commands);
 	elapsedTime += frameDt;
+	frame++;
+
+	// sort before the grid is filled so that cells point into sequential memory
+	framesSinceSort++;
+	if ((sortInterval > 0 && framesSinceSort >= sortInterval) || localityCost > maxLocalityCost)
+		sortParticles();
+
+	updateLod();
+	endPhase(SolverPhase::Sort);
 
 	for (int i = 0; i < numSubSteps; i++)
 	{
+		// coarse particles are only stepped on the last sub-step of every lodRatio sub-steps
+		coarseStep = (i + 1) % lodRatio == 0;
 		applyGravity();
+		endPhase(SolverPhase::Particles);
 		fillCollisionGrid();
-		solveGridCollision();
+		endPhase(SolverPhase::Grid);
+		for (int j = 0; j < numCollisionIterations; j++)
+		{
+			solveGridCollision();
+			if (collisionMode == CollisionMode::Jacobi)
+				applyCollisionDeltas();
+		}
 		//solveCollisions();
+		endPhase(SolverPhase::Collisions);
 		updateParticles(stepDt);
+		endPhase(SolverPhase::Particles);
 		updateConstraints(stepDt);
+		endPhase(SolverPhase::Constraints);
 	}
+
+	localityCost = computeLocalityCost();
+	endPhase(SolverPhase::Sort);
+}
+
+void Solver::endPhase(SolverPhase phase)
+{
+	stats.phaseTimes[(int)phase] += phaseClock.restart().asSeconds();
+}
+
+const SolverStats& Solver::getStats()
+{
+	return stats;
 }
 
 void Solver::applyGravity()
 {
 	for (Particle& particle : particles)
 	{
-		particle.applyForce(gravity);
+		if (coarseStep || !particle.coarse)
+			particle.applyForce(gravity);
 	}
 }
 
@@ -37,7 +78,7 @@ void Solver::applyWind()
 			wind.apply(worldSize.x);
 			if (wind.insideWind(particle))
 			{
-				particle.applyForce({ wind.strength , 0.0f });
+				particle.applyForce({ wind.strength , 0.0f }, getInverseMass(particle));
 			}
 		}
 	}
@@ -47,19 +88,323 @@ void Solver::updateParticles(float dt)
 {
 	for (Particle& particle : particles)
 	{
-		particle.update(dt);
+		if (!particle.coarse)
+			particle.update(dt);
+		else if (coarseStep)
+			updateCoarseParticle(particle, dt * lodRatio);
+		else
+			continue;
 		solveCollisionWithWorld(particle);
 	}
 }
 
 void Solver::updateConstraints(float dt)
 {
+	// Lagrange multipliers are accumulated only inside one sub-step
 	for (Constraint& constraint : constraints)
 	{
-		constraint.update(dt);
+		constraint.lambda = 0.0f;
+	}
+	for (AreaConstraint& area : areas)
+	{
+		area.lambda = 0.0f;
+	}
+	std::fill(bodies.lambdas.begin(), bodies.lambdas.end(), 0.0f);
+	auto inverseMass = [this](const Particle& particle) { return getInverseMass(particle); };
+	for (int i = 0; i < numConstraintIterations; i++)
+	{
+		for (Constraint& constraint : constraints)
+		{
+			if (!constraint.isValid())
+				continue;
+			// links between two coarse particles are solved with the coarse step only
+			if (constraint.p1->coarse && constraint.p2->coarse)
+			{
+				if (coarseStep)
+					constraint.update(dt * lodRatio, getInverseMass(*constraint.p1), getInverseMass(*constraint.p2));
+				continue;
+			}
+			constraint.update(dt, getInverseMass(*constraint.p1), getInverseMass(*constraint.p2));
+		}
+		// bodies made of coarse particles only are solved with the coarse step too
+		for (ShapeConstraint& shape : shapes)
+		{
+			if (bodies.isCoarse(shape.first, shape.count))
+			{
+				if (coarseStep)
+					shape.update(dt * lodRatio, bodies, inverseMass);
+				continue;
+			}
+			shape.update(dt, bodies, inverseMass);
+		}
+		for (AreaConstraint& area : areas)
+		{
+			if (bodies.isCoarse(area.first, area.count))
+			{
+				if (coarseStep)
+					area.update(dt * lodRatio, bodies, inverseMass);
+				continue;
+			}
+			area.update(dt, bodies, inverseMass);
+		}
+	}
+}
+
+bool Solver::pushCommand(const Command& command)
+{
+	return commands.push(command);
+}
+
+bool Solver::pushStrip(const sf::Vector2f* points, int count, bool pinEnds)
+{
+	const int first = (int)stripPoints.size();
+	stripPoints.insert(stripPoints.end(), points, points + count);
+	if (commands.push(Command::spawnStrip(first, count, pinEnds)))
+		return true;
+	stripPoints.resize(first);
+	return false;
+}
+
+void Solver::applyCommands()
+{
+	Command command;
+	while (commands.pop(command))
+	{
+		command.frame = frame;
+		applyCommand(command);
+		if (recording)
+		{
+			// the queued points are cleared below, so recorded strips point to their own copy
+			if (command.type == CommandType::SpawnStrip)
+			{
+				const int first = command.first;
+				command.first = (int)recordedStripPoints.size();
+				recordedStripPoints.insert(recordedStripPoints.end(), stripPoints.begin() + first, stripPoints.begin() + first + command.count);
+			}
+			recordedCommands.push_back(command);
+		}
+	}
+	stripPoints.clear();
+}
+
+void Solver::applyCommand(const Command& command)
+{
+	switch (command.type)
+	{
+	case CommandType::SpawnParticle:
+		if (!command.ifFree || isValidPosition(command.position))
+		{
+			civ::Ref<Particle> particle = addParticle(command.position, command.pinned);
+			particle->initVelocity(command.target, stepDt);
+		}
+		break;
+	case CommandType::SpawnCube:
+		if (!command.ifFree || isValidPosition(command.position))
+			addCube(command.position, 0.0f, command.pinned);
+		break;
+	case CommandType::SpawnCircle:
+		if (!command.ifFree || isValidPosition(command.position))
+			addCircle(command.position, command.radius, command.count);
+		break;
+	case CommandType::Pin:
+	{
+		civ::Ref<Particle> particle = getClickedParticle(command.position);
+		if (particle)
+		{
+			particle->pinned = !particle->pinned;
+			// don't let the particle jump when it is released
+			particle->prevPosition = particle->currentPosition;
+		}
+		break;
+	}
+	case CommandType::Chain:
+	{
+		civ::Ref<Particle> start = getClickedParticle(command.position);
+		civ::Ref<Particle> end = getClickedParticle(command.target);
+		if (start && end && start.getID() != end.getID())
+			addChain(start, end);
+		break;
+	}
+	case CommandType::Force:
+		applyForce(command.radius, command.position);
+		break;
+	case CommandType::Grab:
+	{
+		civ::Ref<Particle> grabbed = getNearestParticle(command.position);
+		if (grabbed)
+		{
+			sf::Vector2f direction = command.position - grabbed->currentPosition;
+			float distance = Math::getLength(direction);
+			if (distance > 0.3f)
+			{
+				sf::Vector2f unit = direction / distance;
+				grabbed->move(unit);
+			}
+		}
+		break;
+	}
+	case CommandType::Remove:
+		removeParticle(getClickedParticle(command.position));
+		break;
+	case CommandType::Wind:
+		applyWind();
+		break;
+	case CommandType::ToggleCollisionMode:
+		// switch between Gauss-Seidel and Jacobi collision response
+		setCollisionMode(collisionMode == CollisionMode::GaussSeidel ? CollisionMode::Jacobi : CollisionMode::GaussSeidel);
+		break;
+	case CommandType::SpawnStrip:
+		addStrip(stripPoints.data() + command.first, command.count, command.pinned);
+		break;
+	}
+}
+
+void Solver::setRecording(bool record)
+{
+	recording = record;
+}
+
+const std::vector<Command>& Solver::getRecordedCommands()
+{
+	return recordedCommands;
+}
+
+const std::vector<sf::Vector2f>& Solver::getRecordedStripPoints()
+{
+	return recordedStripPoints;
+}
+
+// spread the lower 16 bits of a value to the even bits
+static uint32_t spreadBits(uint32_t value)
+{
+	value &= 0x0000ffff;
+	value = (value | (value << 8)) & 0x00ff00ff;
+	value = (value | (value << 4)) & 0x0f0f0f0f;
+	value = (value | (value << 2)) & 0x33333333;
+	value = (value | (value << 1)) & 0x55555555;
+	return value;
+}
+
+void Solver::sortParticles()
+{
+	framesSinceSort = 0;
+	const std::vector<Particle>& data = particles.getData();
+	sortKeys.resize(data.size());
+	for (uint32_t i = 0; i < data.size(); i++)
+	{
+		// Morton code of the cell (interleaved bits of row and column)
+		sf::Vector2i coord = grid.getGridCoordinate(data[i].currentPosition, getRadius(data[i]));
+		sortKeys[i] = { spreadBits(coord.x) << 1 | spreadBits(coord.y), i };
+	}
+	std::sort(sortKeys.begin(), sortKeys.end());
+
+	sortOrder.resize(sortKeys.size());
+	for (size_t i = 0; i < sortKeys.size(); i++)
+	{
+		sortOrder[i] = sortKeys[i].second;
+	}
+	// ids are stable, so Refs (and constraints using them) are still valid
+	particles.reorder(sortOrder);
+	numGridParticles = 0;
+	// side arrays follow the particles
+	for (std::vector<float>* values : { &radii, &inverseMasses })
+	{
+		if (values->empty())
+			continue;
+		sortScratch.resize(sortOrder.size());
+		for (size_t i = 0; i < sortOrder.size(); i++)
+		{
+			sortScratch[i] = (*values)[sortOrder[i]];
+		}
+		std::swap(*values, sortScratch);
 	}
 }
 
+float Solver::computeLocalityCost()
+{
+	// average distance in memory between two particles sharing a cell
+	// (this is a cheap proxy of the cache misses of collision solving)
+	int64_t totalGap = 0;
+	int numPairs = 0;
+	for (CollisionCell& cell : grid.grid)
+	{
+		for (int i = 1; i < cell.numObjects; i++)
+		{
+			totalGap += std::abs((int64_t)cell.objects[i] - (int64_t)cell.objects[i - 1]);
+			numPairs++;
+		}
+	}
+	return numPairs > 0 ? (float)totalGap / numPairs : 0.0f;
+}
+
+void Solver::setSortInterval(const int frames)
+{
+	sortInterval = frames;
+}
+
+void Solver::updateLod()
+{
+	// the ratio only changes between two frames and must divide the number of sub-steps
+	const int previousRatio = lodRatio;
+	lodRatio = requestedLodRatio > 1 && numSubSteps % requestedLodRatio == 0 ? requestedLodRatio : 1;
+
+	const sf::FloatRect area(activeArea.left - lodMargin, activeArea.top - lodMargin,
+		activeArea.width + 2.0f * lodMargin, activeArea.height + 2.0f * lodMargin);
+	numCoarseParticles = 0;
+	for (Particle& particle : particles)
+	{
+		const bool coarse = lodRatio > 1 && !area.contains(particle.currentPosition);
+		numCoarseParticles += coarse;
+		// the displacement of Verlet integration is the velocity times the step, so it is rescaled
+		// to the new step to keep the velocity (no pop or energy change when switching)
+		const float scale = (coarse ? lodRatio : 1.0f) / (particle.coarse ? previousRatio : 1.0f);
+		if (scale != 1.0f)
+			particle.prevPosition = particle.currentPosition - (particle.currentPosition - particle.prevPosition) * scale;
+		particle.coarse = coarse;
+	}
+
+	// fine particles can only be in cells touching the area (plus their neighbors)
+	const sf::Vector2i topLeft = grid.getGridCoordinate({ area.left, area.top }, 0.0f);
+	const sf::Vector2i bottomRight = grid.getGridCoordinate({ area.left + area.width, area.top + area.height }, 0.0f);
+	const int top = std::max(topLeft.x - 1, 0);
+	const int left = std::max(topLeft.y - 1, 0);
+	const int bottom = std::min(bottomRight.x + 1, grid.numRows - 1);
+	const int right = std::min(bottomRight.y + 1, grid.numCols - 1);
+	activeCells = { left, top, right - left + 1, bottom - top + 1 };
+}
+
+void Solver::updateCoarseParticle(Particle& particle, float dt)
+{
+	// long steps are less stable in crowded places, so the displacement of one step is kept
+	// under the radius (this can only remove energy, never add it)
+	const float maxDisplacement = getRadius(particle);
+	const sf::Vector2f displacement = particle.currentPosition - particle.prevPosition;
+	const float length = Math::getLength(displacement);
+	if (length > maxDisplacement)
+		particle.prevPosition = particle.currentPosition - displacement * (maxDisplacement / length);
+	particle.update(dt);
+}
+
+void Solver::setActiveArea(const sf::FloatRect& area)
+{
+	activeArea = area;
+}
+
+void Solver::setLodRatio(const int ratio)
+{
+	requestedLodRatio = ratio;
+}
+
+void Solver::setLodMargin(const float margin)
+{
+	lodMargin = margin;
+}
+
+const int Solver::getNumCoarseParticles()
+{
+	return numCoarseParticles;
+}
+
 void Solver::applyForce(float radius, const sf::Vector2f& position)
 {
 	for (Particle& particle : particles)
@@ -68,18 +413,82 @@ void Solver::applyForce(float radius, const sf::Vector2f& position)
 		float distance = Math::getLength(direction);
 		if (distance < radius)
 		{
-			particle.applyForce(1.f * (radius - distance) * direction);
+			particle.applyForce(1.f * (radius - distance) * direction, getInverseMass(particle));
 		}
 	}
 }
 
 civ::Ref<Particle> Solver::addParticle(const sf::Vector2f& position, bool pinned)
 {
-	civ::ID id = particles.emplace_back(position, particleRadius, pinned);
-	particles[id].id = id;
+	civ::ID id = particles.emplace_back(position, pinned);
+	if (!radii.empty())
+		radii.push_back(particleRadius);
+	if (!inverseMasses.empty())
+		inverseMasses.push_back(1.0f);
 	return particles.createRef(id);
 }
 
+void Solver::removeParticle(civ::Ref<Particle> particle)
+{
+	if (!particle)
+		return;
+	// the last particle is moved into the freed slot, so do the same with the side arrays
+	const civ::ID index = particles.getDataIndex(particle.getID());
+	if (!radii.empty())
+	{
+		radii[index] = radii.back();
+		radii.pop_back();
+	}
+	if (!inverseMasses.empty())
+	{
+		inverseMasses[index] = inverseMasses.back();
+		inverseMasses.pop_back();
+	}
+	particles.erase(particle.getID());
+	// the grid still holds the old data indices
+	numGridParticles = 0;
+
+	// anything holding the particle lost its reference
+	constraints.remove_if([](Constraint& constraint) { return !constraint.isValid(); });
+	linksChanged = true;
+	const size_t numBodies = shapes.size() + areas.size();
+	shapes.remove_if([this](ShapeConstraint& shape) { return !shape.isValid(bodies); });
+	areas.remove_if([this](AreaConstraint& area) { return !area.isValid(bodies); });
+	if (shapes.size() + areas.size() != numBodies)
+		compactBodies();
+}
+
+void Solver::compactBodies()
+{
+	// ranges are moved in their order, so a range never overwrites one that wasn't moved yet
+	struct Range
+	{
+		int* first;
+		int count;
+	};
+	const int numBodies = (int)(shapes.size() + areas.size());
+	Range* ranges = scratch.allocate<Range>(numBodies);
+	int numRanges = 0;
+	for (ShapeConstraint& shape : shapes)
+	{
+		ranges[numRanges++] = { &shape.first, shape.count };
+	}
+	for (AreaConstraint& area : areas)
+	{
+		ranges[numRanges++] = { &area.first, area.count };
+	}
+	std::sort(ranges, ranges + numRanges, [](const Range& a, const Range& b) { return *a.first < *b.first; });
+	int size = 0;
+	for (int i = 0; i < numRanges; i++)
+	{
+		bodies.move(*ranges[i].first, ranges[i].count, size);
+		*ranges[i].first = size;
+		size += ranges[i].count;
+	}
+	bodies.resize(size);
+	scratch.reset();
+}
+
 const civ::IndexVector<Particle>& Solver::getParticles()
 {
 	return particles;
@@ -90,13 +499,54 @@ const int Solver::getNumParticles()
 	return particles.size();
 }
 
+float Solver::getRadius(const Particle& particle)
+{
+	if (radii.empty())
+		return particleRadius;
+	// particles are stored contiguously, so the address gives its data index
+	return radii[&particle - particles.getData().data()];
+}
+
+float Solver::getInverseMass(const Particle& particle)
+{
+	// pinned particles behave like infinite masses
+	if (particle.pinned)
+		return 0.0f;
+	if (inverseMasses.empty())
+		return 1.0f;
+	return inverseMasses[&particle - particles.getData().data()];
+}
+
+void Solver::setRadius(civ::Ref<Particle> particle, float radius)
+{
+	if (radii.empty())
+	{
+		if (radius == particleRadius)
+			return;
+		radii.assign(particles.size(), particleRadius);
+	}
+	radii[particles.getDataIndex(particle.getID())] = radius;
+}
+
+void Solver::setMass(civ::Ref<Particle> particle, float mass)
+{
+	if (inverseMasses.empty())
+	{
+		if (mass == 1.0f)
+			return;
+		inverseMasses.assign(particles.size(), 1.0f);
+	}
+	inverseMasses[particles.getDataIndex(particle.getID())] = 1.0f / mass;
+}
+
 civ::Ref<Particle> Solver::getClickedParticle(const sf::Vector2f& clickedPosition)
 {
-	for (Particle& particle : particles)
+	const std::vector<Particle>& data = particles.getData();
+	for (civ::ID i = 0; i < data.size(); i++)
 	{
-		if (Math::getDistance(particle.currentPosition, clickedPosition) <= particle.radius)
+		if (Math::getDistance(data[i].currentPosition, clickedPosition) <= getRadius(data[i]))
 		{
-			return particles.createRef(particle.id);
+			return particles.createRef(particles.getIDAt(i));
 		}
 	}
 	// if none of particles are near, return empty Ref
@@ -107,25 +557,27 @@ civ::Ref<Particle> Solver::getNearestParticle(const sf::Vector2f& position)
 {
 	float minDistance = 9999.9f;
 	civ::Ref<Particle> nearest;
-	for (Particle& particle : particles)
+	const std::vector<Particle>& data = particles.getData();
+	for (civ::ID i = 0; i < data.size(); i++)
 	{
-		float distance = Math::getDistance(particle.currentPosition, position);
+		float distance = Math::getDistance(data[i].currentPosition, position);
 		if (distance < minDistance)
 		{
 			minDistance = distance;
-			nearest = particles.createRef(particle.id);
+			nearest = particles.createRef(particles.getIDAt(i));
 		}
 	}
 	return nearest;
 }
 
-civ::Ref<Constraint> Solver::addConstraint(civ::Ref<Particle> p1, civ::Ref<Particle> p2, float distance, float strength)
+civ::Ref<Constraint> Solver::addConstraint(civ::Ref<Particle> p1, civ::Ref<Particle> p2, float distance, float compliance, bool collidable)
 {
 	civ::ID id = 0;
 	if (distance < 0.0f)
-		id = constraints.emplace_back(p1, p2, Math::getLength(p1->currentPosition - p2->currentPosition), strength);
+		id = constraints.emplace_back(p1, p2, Math::getLength(p1->currentPosition - p2->currentPosition), compliance, collidable);
 	else
-		id = constraints.emplace_back(p1, p2, distance, strength);
+		id = constraints.emplace_back(p1, p2, distance, compliance, collidable);
+	linksChanged = true;
 	return constraints.createRef(id);
 }
 
@@ -139,6 +591,33 @@ const int Solver::getNumLinks()
 	return constraints.size();
 }
 
+civ::Ref<ShapeConstraint> Solver::addShape(const civ::Ref<Particle>* particles, int count, float compliance)
+{
+	civ::ID id = shapes.emplace_back(bodies, particles, count, compliance);
+	return shapes.createRef(id);
+}
+
+const civ::IndexVector<ShapeConstraint>& Solver::getShapes()
+{
+	return shapes;
+}
+
+civ::Ref<AreaConstraint> Solver::addArea(const civ::Ref<Particle>* ring, int count, float compliance, float pressure)
+{
+	civ::ID id = areas.emplace_back(bodies, ring, count, compliance, pressure);
+	return areas.createRef(id);
+}
+
+const civ::IndexVector<AreaConstraint>& Solver::getAreas()
+{
+	return areas;
+}
+
+const BodyStorage& Solver::getBodies()
+{
+	return bodies;
+}
+
 civ::Ref<Wind> Solver::addWind(const sf::Vector2f& position, const sf::Vector2f& size, float speed, float strength)
 {
 	civ::ID id = winds.emplace_back(position, size, speed, strength);
@@ -151,111 +630,186 @@ const civ::IndexVector<Wind>& Solver::getWinds()
 }
 
 
-void Solver::addCube(const sf::Vector2f& position, float stiffness, bool pinned)
+void Solver::reserve(int numParticles, int numConstraints)
 {
-	// use offset so that cube will be drawn at exactly that position
-	float offset = 2 * particleRadius;
+	// grow geometrically so that reserving before every batch doesn't reallocate every time
+	const size_t particleCapacity = particles.size() + numParticles;
+	if (particleCapacity > particles.capacity())
+		particles.reserve(std::max(particleCapacity, 2 * particles.capacity()));
+	const size_t constraintCapacity = constraints.size() + numConstraints;
+	if (constraintCapacity > constraints.capacity())
+		constraints.reserve(std::max(constraintCapacity, 2 * constraints.capacity()));
+}
 
-	// a cube is composed of 9 particles and constraints at every edge and diagonal
+Batch& Solver::beginBatch()
+{
+	buildBatch.clear();
+	return buildBatch;
+}
+
+void Solver::commitBatch(Batch& batch)
+{
+	// storage only grows once for the whole batch
+	reserve(batch.numNewParticles, batch.constraints.size());
+
+	civ::Ref<Particle>* refs = scratch.allocate<civ::Ref<Particle>>(batch.particles.size());
+	for (size_t i = 0; i < batch.particles.size(); i++)
+	{
+		const Batch::ParticleEntry& entry = batch.particles[i];
+		refs[i] = entry.existing ? entry.ref : addParticle(entry.position, entry.pinned);
+	}
+	for (const Batch::ConstraintEntry& entry : batch.constraints)
+	{
+		addConstraint(refs[entry.p1], refs[entry.p2], -1.0f, entry.compliance, entry.collidable);
+	}
+	batch.clear();
+	// temporaries are not needed anymore (this also works when the simulation is paused)
+	scratch.reset();
+}
+
+void Solver::addPrefab(const Prefab& prefab, const sf::Vector2f& position, float angle, bool pinned, float compliance)
+{
+	const int numParticles = prefab.getNumParticles();
+	const int numLinks = (int)prefab.links.size();
+	reserve(numParticles, numLinks);
+
+	// transform the particles into the world, rest lengths stay the same under rotation
+	const float cosAngle = std::cos(angle);
+	const float sinAngle = std::sin(angle);
+	Particle* newParticles = scratch.allocate<Particle>(numParticles);
+	for (int i = 0; i < numParticles; i++)
+	{
+		const sf::Vector2f& offset = prefab.offsets[i];
+		const sf::Vector2f rotated(offset.x * cosAngle - offset.y * sinAngle, offset.x * sinAngle + offset.y * cosAngle);
+		newParticles[i] = Particle(position + rotated, pinned || prefab.pinMask[i]);
+	}
+	civ::ID* ids = scratch.allocate<civ::ID>(numParticles);
+	particles.push_back(newParticles, numParticles, ids);
+	if (!radii.empty())
+		radii.resize(particles.size(), particleRadius);
+	if (!inverseMasses.empty())
+		inverseMasses.resize(particles.size(), 1.0f);
+
+	Constraint* newConstraints = scratch.allocate<Constraint>(numLinks);
+	for (int i = 0; i < numLinks; i++)
+	{
+		const Prefab::Link& link = prefab.links[i];
+		newConstraints[i] = Constraint(particles.createRef(ids[link.p1]), particles.createRef(ids[link.p2]), link.length,
+			compliance < 0.0f ? link.compliance : compliance, link.collidable);
+	}
+	constraints.push_back(newConstraints, numLinks);
+	linksChanged = true;
+
+	// a rigid body only needs one shape matching constraint
+	if (prefab.rigid)
+	{
+		civ::Ref<Particle>* refs = scratch.allocate<civ::Ref<Particle>>(numParticles);
+		for (int i = 0; i < numParticles; i++)
+		{
+			refs[i] = particles.createRef(ids[i]);
+		}
+		addShape(refs, numParticles, compliance < 0.0f ? prefab.rigidCompliance : compliance);
+	}
+	// a closed ring only needs one area constraint
+	if (!prefab.ring.empty())
+	{
+		const int ringSize = (int)prefab.ring.size();
+		civ::Ref<Particle>* refs = scratch.allocate<civ::Ref<Particle>>(ringSize);
+		for (int i = 0; i < ringSize; i++)
+		{
+			refs[i] = particles.createRef(ids[prefab.ring[i]]);
+		}
+		addArea(refs, ringSize, compliance < 0.0f ? prefab.ringCompliance : compliance, prefab.ringPressure);
+	}
+	scratch.reset();
+}
+
+void Solver::addCube(const sf::Vector2f& position, float compliance, bool pinned)
+{
+	// a cube is composed of 9 particles kept in shape by a single shape matching constraint
 	// I use more particles in order to simulate more dynamic motion
-	civ::Ref<Particle> p1 = addParticle({ position.x - offset, position.y - offset }, pinned);
-	civ::Ref<Particle> p2 = addParticle({ position.x, position.y - offset }, pinned);
-	civ::Ref<Particle> p3 = addParticle({ position.x + offset, position.y - offset }, pinned);
-	civ::Ref<Particle> p4 = addParticle({ position.x - offset, position.y }, pinned);
-	civ::Ref<Particle> p5 = addParticle({ position.x , position.y }, pinned);
-	civ::Ref<Particle> p6 = addParticle({ position.x + offset, position.y }, pinned);
-	civ::Ref<Particle> p7 = addParticle({ position.x - offset, position.y + offset }, pinned);
-	civ::Ref<Particle> p8 = addParticle({ position.x, position.y + offset }, pinned);
-	civ::Ref<Particle> p9 = addParticle({ position.x + offset, position.y + offset }, pinned);
-	// edges
-	addConstraint(p1, p2, -1.0f, stiffness);
-	addConstraint(p2, p3, -1.0f, stiffness);
-	addConstraint(p1, p4, -1.0f, stiffness);
-	addConstraint(p2, p5, -1.0f, stiffness);
-	addConstraint(p3, p6, -1.0f, stiffness);
-	addConstraint(p4, p5, -1.0f, stiffness);
-	addConstraint(p5, p6, -1.0f, stiffness);
-	addConstraint(p4, p7, -1.0f, stiffness);
-	addConstraint(p5, p8, -1.0f, stiffness);
-	addConstraint(p6, p9, -1.0f, stiffness);
-	addConstraint(p7, p8, -1.0f, stiffness);
-	addConstraint(p8, p9, -1.0f, stiffness);
-	// main diagonal
-	addConstraint(p1, p5, -1.0, stiffness);
-	addConstraint(p2, p6, -1.0, stiffness);
-	addConstraint(p4, p8, -1.0, stiffness);
-	addConstraint(p5, p9, -1.0, stiffness);
-}
-
-void Solver::addChain(civ::Ref<Particle> p1, civ::Ref<Particle> p2)
+	addPrefab(cubePrefab, position, 0.0f, pinned, compliance);
+}
+
+void Solver::addChain(civ::Ref<Particle> p1, civ::Ref<Particle> p2, bool solid)
 {
 	// calculate how much particles needed
 	sf::Vector2f direction = p2->currentPosition - p1->currentPosition;
 	float length = Math::getLength(direction);
 	sf::Vector2f unit = direction / length;
-	int numParticles = length / (2 * particleRadius) + 1;
+	int numParticles = std::max(2, (int)(length / (2 * particleRadius)) + 1);
 	float offset = 2 * particleRadius;
 
-	std::vector<civ::Ref<Particle>> ps(numParticles);
-	// manually create the first one and the last one
+	// the first one and the last one are the given particles
 	p1->pinned = true;
 	p2->pinned = true;
-	ps[0] = p1;
-	ps[numParticles - 1] = p2;
+	Batch& chain = beginBatch();
+	int previous = chain.addExisting(p1);
 
 	sf::Vector2f chainPosition(p1->currentPosition.x, p1->currentPosition.y);
 
-	// create rest ones along the y axis
+	// create rest ones along the chain and link them (solid links block particles between two chain particles)
 	for (int i = 1; i < numParticles - 1; i++)
 	{
 		chainPosition += offset * unit;
-		ps[i] = addParticle(chainPosition);
-	}
-	// add constraints
-	for (int i = 1; i < numParticles; i++)
-	{
-		addConstraint(ps[i - 1], ps[i]);
+		int current = chain.addParticle(chainPosition);
+		chain.addConstraint(previous, current, 0.0f, solid);
+		previous = current;
 	}
+	chain.addConstraint(previous, chain.addExisting(p2), 0.0f, solid);
+	commitBatch(chain);
 }
 
-void Solver::addCircle(const sf::Vector2f& position, float radius, int numParticles, float stiffness, bool pinCenter, bool pinOuter)
+void Solver::addStrip(const sf::Vector2f* positions, int count, bool pinEnds, bool solid)
 {
-	// small angle for every particle (2 * pi / numParticles)
-	float delta = 2.0f * Math::PI / float(numParticles);
-	// center of circle
-	civ::Ref<Particle> center = addParticle(position, pinCenter);
-	// store outer particles
-	std::vector<civ::Ref<Particle>> outerParticles(numParticles);
-
-	for (int i = 0; i < numParticles; i++)
+	if (count <= 0)
+		return;
+	Batch& strip = beginBatch();
+	int previous = strip.addParticle(positions[0], pinEnds);
+	for (int i = 1; i < count; i++)
 	{
-		float x = radius * std::cos(i * delta);
-		float y = radius * std::sin(i * delta);
-		civ::Ref<Particle> particle = addParticle({ position.x + x, position.y + y }, pinOuter);
-		outerParticles[i] = particle;
-		// add constraint to center
-		addConstraint(particle, center, -1.0f, stiffness);
+		const bool last = i + 1 == count;
+		int current = strip.addParticle(positions[i], pinEnds && last);
+		strip.addConstraint(previous, current, 0.0f, solid);
+		previous = current;
 	}
+	commitBatch(strip);
+}
 
-	// connect every outer particle with their adjacent particles
-	for (int i = 0; i < numParticles; i++)
+void Solver::addCircle(const sf::Vector2f& position, float radius, int numParticles, float compliance, bool pinCenter, bool pinOuter)
+{
+	// cos and sin of the outer particles are only computed when the shape changes
+	if (radius != circleRadius || numParticles != circleNumParticles || pinCenter != circlePinCenter || pinOuter != circlePinOuter)
 	{
-		// connect adjacent and a further particle to make sure the structure is strong
-		// reference: https://github.com/subprotocol/verlet-js/blob/master/lib/objects.js#L102
-		int adjacent = (i + 1) % numParticles;
-		int far = (i + 5) % numParticles;
-		addConstraint(outerParticles[i], outerParticles[adjacent], -1.0f, stiffness);
-		addConstraint(outerParticles[i], outerParticles[far], -1.0f, stiffness);
+		circlePrefab = Prefab::makeCircle(radius, numParticles, 0.0f, pinCenter, pinOuter);
+		circleRadius = radius;
+		circleNumParticles = numParticles;
+		circlePinCenter = pinCenter;
+		circlePinOuter = pinOuter;
 	}
+	addPrefab(circlePrefab, position, 0.0f, false, compliance);
 }
 
 bool Solver::isValidPosition(const sf::Vector2f& position)
 {
-	sf::Vector2i coord = grid.getGridCoordinate(position, particleRadius);
-	CollisionCell& cell = grid.getCell(coord.x, coord.y);
-	for (int i = 0; i < cell.numObjects; i++)
+	const float minDistance = 2 * particleRadius - 2.0f;
+	const std::vector<Particle>& data = particles.getData();
+	if (numGridParticles > 0)
+	{
+		sf::Vector2i coord = grid.getGridCoordinate(position, particleRadius);
+		CollisionCell& cell = grid.getCell(coord.x, coord.y);
+		for (int i = 0; i < cell.numObjects; i++)
+		{
+			if (Math::getDistance(position, data[cell.objects[i]].currentPosition) < minDistance)
+			{
+				return false;
+			}
+		}
+	}
+	// the grid doesn't know the particles spawned by earlier commands (or any particle once it is out of date)
+	for (size_t i = numGridParticles; i < data.size(); i++)
 	{
-		if (Math::getDistance(position, cell.objects[i]->currentPosition) < 2 * particleRadius - 2.0f)
+		if (Math::getDistance(position, data[i].currentPosition) < minDistance)
 		{
 			return false;
 		}
@@ -268,24 +822,30 @@ const sf::Vector3f Solver::getWorld()
 	return { worldSize.x, worldSize.y, particleRadius };
 }
 
+const sf::Vector2f Solver::getGravity()
+{
+	return gravity;
+}
+
 void Solver::solveCollisionWithWorld(Particle& particle)
 {
+	const float radius = getRadius(particle);
 	// if particle out of world, put it back
-	if (particle.currentPosition.x > worldSize.x - particleRadius)
+	if (particle.currentPosition.x > worldSize.x - radius)
 	{
-		particle.currentPosition.x = worldSize.x - particleRadius;
+		particle.currentPosition.x = worldSize.x - radius;
 	}
-	else if (particle.currentPosition.x < particleRadius)
+	else if (particle.currentPosition.x < radius)
 	{
-		particle.currentPosition.x = particleRadius;
+		particle.currentPosition.x = radius;
 	}
-	if (particle.currentPosition.y > worldSize.y - particleRadius)
+	if (particle.currentPosition.y > worldSize.y - radius)
 	{
-		particle.currentPosition.y = worldSize.y - particleRadius;
+		particle.currentPosition.y = worldSize.y - radius;
 	}
-	else if (particle.currentPosition.y < particleRadius)
+	else if (particle.currentPosition.y < radius)
 	{
-		particle.currentPosition.y = particleRadius;
+		particle.currentPosition.y = radius;
 	}
 }
 
@@ -295,18 +855,19 @@ void Solver::solveCollisions()
 	const float responseStrength = 1.0f;
 
 	// naive O(n^2) method
-	for (int i = 0; i < particles.size(); i++)
+	std::vector<Particle>& data = particles.getData();
+	for (int i = 0; i < data.size(); i++)
 	{
-		Particle& p1 = particles[i];
+		Particle& p1 = data[i];
 
-		for (int j = i + 1; j < particles.size(); j++)
+		for (int j = i + 1; j < data.size(); j++)
 		{
-			Particle& p2 = particles[j];
+			Particle& p2 = data[j];
 
 			sf::Vector2f direction = p1.currentPosition - p2.currentPosition;
 			float distance = Math::getLength(direction);
 			// the min distance to not overlap is the sum of radius
-			const float minDistance = p1.radius + p2.radius;
+			const float minDistance = getRadius(p1) + getRadius(p2);
 
 			if (distance < minDistance)
 			{
@@ -329,21 +890,295 @@ CollisionGrid& Solver::getGrid()
 	return grid;
 }
 
+void Solver::writeRenderState(RenderState& state)
+{
+	phaseClock.restart();
+	state.clear();
+	const int numCells = (int)grid.grid.size();
+	auto getCellIndex = [&](const sf::Vector2f& position, float radius)
+	{
+		const sf::Vector2i coord = grid.getGridCoordinate(position, radius);
+		return coord.x * grid.numCols + coord.y;
+	};
+
+	// group the particles by cell with a counting sort so that the renderer can pick visible cells
+	const std::vector<Particle>& data = particles.getData();
+	renderCells.resize(data.size());
+	state.particleStarts.assign(numCells + 1, 0);
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		const float radius = getRadius(data[i]);
+		state.maxRadius = std::max(state.maxRadius, radius);
+		renderCells[i] = getCellIndex(data[i].currentPosition, radius);
+		state.particleStarts[renderCells[i] + 1]++;
+	}
+	for (int i = 0; i < numCells; i++)
+		state.particleStarts[i + 1] += state.particleStarts[i];
+	state.positions.resize(data.size());
+	state.radii.resize(data.size());
+	state.speeds.resize(data.size());
+	// the previous position is the one of the last sub-step
+	const float inverseStepDt = stepDt > 0.0f ? 1.0f / stepDt : 0.0f;
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		// the starts are used as insertion points and shifted back afterwards
+		const int slot = state.particleStarts[renderCells[i]]++;
+		state.positions[slot] = data[i].currentPosition;
+		state.radii[slot] = getRadius(data[i]);
+		state.speeds[slot] = Math::getDistance(data[i].currentPosition, data[i].prevPosition) * inverseStepDt;
+	}
+	for (int i = numCells; i > 0; i--)
+		state.particleStarts[i] = state.particleStarts[i - 1];
+	state.particleStarts[0] = 0;
+
+	// same for the links that are not part of a chain, by their middle point
+	if (linksChanged)
+		findLinkTopology();
+	const std::vector<Constraint>& links = constraints.getData();
+	renderCells.resize(links.size());
+	state.linkStarts.assign(numCells + 1, 0);
+	int numLinks = 0;
+	for (size_t i = 0; i < links.size(); i++)
+	{
+		// the strain is left by the constraint solver, so this is the only pass over it
+		float& maxStrain = structureMaxStrains[linkStructures[i]];
+		maxStrain = std::max(maxStrain, std::abs(links[i].strain));
+		if (chainLinks[i])
+			continue;
+		const sf::Vector2f& start = links[i].p1->currentPosition;
+		const sf::Vector2f& end = links[i].p2->currentPosition;
+		state.maxLinkLength = std::max(state.maxLinkLength, Math::getDistance(start, end));
+		renderCells[i] = getCellIndex(0.5f * (start + end), 0.0f);
+		state.linkStarts[renderCells[i] + 1]++;
+		numLinks++;
+	}
+	for (int i = 0; i < numCells; i++)
+		state.linkStarts[i + 1] += state.linkStarts[i];
+	state.links.resize(2 * numLinks);
+	state.linkStrains.resize(numLinks);
+	for (size_t i = 0; i < links.size(); i++)
+	{
+		if (chainLinks[i])
+			continue;
+		const int slot = state.linkStarts[renderCells[i]]++;
+		state.links[2 * slot] = links[i].p1->currentPosition;
+		state.links[2 * slot + 1] = links[i].p2->currentPosition;
+		state.linkStrains[slot] = links[i].strain;
+	}
+	for (int i = numCells; i > 0; i--)
+		state.linkStarts[i] = state.linkStarts[i - 1];
+	state.linkStarts[0] = 0;
+
+	state.chainPoints.reserve(chainParticles.size());
+	for (civ::ID id : chainParticles)
+		state.chainPoints.push_back(particles[id].currentPosition);
+	state.chainStrains.resize(chainParticles.size());
+	for (int c = 0; c + 1 < (int)chainStarts.size(); c++)
+	{
+		// chain c has one link less than points, its links start at chainStarts[c] - c
+		const int first = chainStarts[c];
+		const int last = chainStarts[c + 1] - 1;
+		const int* chainLinkIndex = &chainLinkIndices[first - c];
+		state.chainStrains[first] = links[chainLinkIndex[0]].strain;
+		for (int i = first + 1; i < last; i++)
+			state.chainStrains[i] = 0.5f * (links[chainLinkIndex[i - first - 1]].strain + links[chainLinkIndex[i - first]].strain);
+		state.chainStrains[last] = links[chainLinkIndex[last - first - 1]].strain;
+		// a closed chain repeats its first particle, which is between its first and last link
+		if (chainParticles[first] == chainParticles[last])
+			state.chainStrains[first] = state.chainStrains[last] = 0.5f * (state.chainStrains[first] + state.chainStrains[last]);
+	}
+	state.chainStarts = chainStarts;
+	// shape-matched bodies have no links, so their outline is drawn instead
+	state.outlineStarts.push_back(0);
+	for (const ShapeConstraint& shape : shapes)
+	{
+		if (shape.outlineCount < 2)
+			continue;
+		for (int i = shape.first; i < shape.first + shape.outlineCount; i++)
+			state.outlinePoints.push_back(bodies.particles[i]->currentPosition);
+		state.outlinePoints.push_back(bodies.particles[shape.first]->currentPosition);
+		state.outlineStarts.push_back((int)state.outlinePoints.size());
+	}
+	state.structureMaxStrains = structureMaxStrains;
+	state.cellCounts.reserve(grid.grid.size());
+	for (const CollisionCell& cell : grid.grid)
+		state.cellCounts.push_back((uint8_t)cell.numObjects);
+
+	stats.numParticles = (int)particles.size();
+	stats.numCoarseParticles = numCoarseParticles;
+	stats.numLinks = (int)constraints.size();
+	stats.numShapes = (int)shapes.size();
+	stats.numAreas = (int)areas.size();
+	stats.storageBytes = particles.capacity() * sizeof(Particle) + constraints.capacity() * sizeof(Constraint)
+		+ shapes.capacity() * sizeof(ShapeConstraint) + areas.capacity() * sizeof(AreaConstraint) + bodies.getBytes();
+	stats.gridBytes = grid.grid.capacity() * sizeof(CollisionCell);
+	stats.scratchBytes = scratch.getCapacity();
+	// the copy itself is the only part that isn't counted
+	stats.phaseTimes[(int)SolverPhase::Output] = phaseClock.getElapsedTime().asSeconds();
+	state.stats = stats;
+}
+
+void Solver::findLinkTopology()
+{
+	linksChanged = false;
+	chainParticles.clear();
+	chainStarts.assign(1, 0);
+	chainLinkIndices.clear();
+	const std::vector<Constraint>& links = constraints.getData();
+	const int numLinks = (int)links.size();
+	const int numParticles = (int)particles.size();
+	chainLinks.assign(numLinks, 0);
+
+	// adjacency of the particles (by data index) in compressed rows, each entry is a neighbor and the link to it
+	int* offsets = scratch.allocate<int>(numParticles + 1);
+	int* fill = scratch.allocate<int>(numParticles);
+	std::pair<int, int>* adjacency = scratch.allocate<std::pair<int, int>>(2 * numLinks);
+	for (const Constraint& link : links)
+	{
+		offsets[particles.getDataIndex(link.p1.getID()) + 1]++;
+		offsets[particles.getDataIndex(link.p2.getID()) + 1]++;
+	}
+	for (int i = 0; i < numParticles; i++)
+	{
+		offsets[i + 1] += offsets[i];
+		fill[i] = offsets[i];
+	}
+	for (int i = 0; i < numLinks; i++)
+	{
+		const int p1 = (int)particles.getDataIndex(links[i].p1.getID());
+		const int p2 = (int)particles.getDataIndex(links[i].p2.getID());
+		adjacency[fill[p1]++] = { p2, i };
+		adjacency[fill[p2]++] = { p1, i };
+	}
+	auto degree = [&](int particle) { return offsets[particle + 1] - offsets[particle]; };
+
+	uint8_t* visited = scratch.allocate<uint8_t>(numLinks);
+	int* walked = scratch.allocate<int>(numLinks);
+	// follow links from start until a particle that doesn't have exactly two links (or the start again)
+	auto walk = [&](int start, int entry)
+	{
+		const int begin = (int)chainParticles.size();
+		int numWalked = 0;
+		chainParticles.push_back(particles.getIDAt(start));
+		while (true)
+		{
+			const int link = adjacency[entry].second;
+			const int current = adjacency[entry].first;
+			visited[link] = 1;
+			walked[numWalked++] = link;
+			chainParticles.push_back(particles.getIDAt(current));
+			if (current == start || degree(current) != 2)
+				break;
+			// leave through the other link
+			entry = offsets[current];
+			if (adjacency[entry].second == link)
+				entry++;
+			if (visited[adjacency[entry].second])
+				break;
+		}
+		// a single link is not a chain
+		if (numWalked < 2)
+		{
+			chainParticles.resize(begin);
+			return;
+		}
+		for (int i = 0; i < numWalked; i++)
+		{
+			chainLinks[walked[i]] = 1;
+			chainLinkIndices.push_back(walked[i]);
+		}
+		chainStarts.push_back((int)chainParticles.size());
+	};
+
+	// open chains start at particles that don't have exactly two links
+	for (int p = 0; p < numParticles; p++)
+	{
+		if (degree(p) == 2)
+			continue;
+		for (int j = offsets[p]; j < offsets[p + 1]; j++)
+		{
+			if (!visited[adjacency[j].second])
+				walk(p, j);
+		}
+	}
+	// what is left are closed loops
+	for (int p = 0; p < numParticles; p++)
+	{
+		if (degree(p) == 2 && !visited[adjacency[offsets[p]].second])
+			walk(p, offsets[p]);
+	}
+
+	// structures are the connected parts of the adjacency (their running maximum strains start over)
+	int* structures = scratch.allocate<int>(numParticles);
+	int* stack = scratch.allocate<int>(numParticles);
+	int numStructures = 0;
+	for (int p = 0; p < numParticles; p++)
+	{
+		if (structures[p] != 0 || degree(p) == 0)
+			continue;
+		// labels start at 1 so that 0 means not visited yet
+		numStructures++;
+		int stackSize = 0;
+		stack[stackSize++] = p;
+		structures[p] = numStructures;
+		while (stackSize > 0)
+		{
+			const int current = stack[--stackSize];
+			for (int j = offsets[current]; j < offsets[current + 1]; j++)
+			{
+				const int neighbor = adjacency[j].first;
+				if (structures[neighbor] == 0)
+				{
+					structures[neighbor] = numStructures;
+					stack[stackSize++] = neighbor;
+				}
+			}
+		}
+	}
+	linkStructures.resize(numLinks);
+	for (int i = 0; i < numLinks; i++)
+		linkStructures[i] = structures[particles.getDataIndex(links[i].p1.getID())] - 1;
+	structureMaxStrains.assign(numStructures, 0.0f);
+	scratch.reset();
+}
+
 void Solver::fillCollisionGrid()
 {
 	// initialize the grid
 	grid.clearGrid();
-	for (Particle& particle : particles)
+	if (collisionMode == CollisionMode::Jacobi)
+	{
+		collisionDeltas.assign(particles.size(), { 0.0f, 0.0f });
+		collisionCounts.assign(particles.size(), 0);
+	}
+	const std::vector<Particle>& data = particles.getData();
+	numGridParticles = data.size();
+	for (civ::ID i = 0; i < data.size(); i++)
 	{
-		grid.addObject(particle);
+		if (!grid.addObject(i, data[i].currentPosition, getRadius(data[i])))
+			stats.numDroppedObjects++;
+	}
+	std::vector<Constraint>& links = constraints.getData();
+	linkStamps.assign(links.size(), 0);
+	linkStamp = 0;
+	for (civ::ID i = 0; i < links.size(); i++)
+	{
+		Constraint& link = links[i];
+		if (link.collidable && link.isValid())
+			stats.numDroppedLinks += grid.addLink(i, link.p1->currentPosition, link.p2->currentPosition, getRadius(*link.p1));
 	}
 }
 
 void Solver::solveGridCollision()
 {
-	for (int row = 0; row < grid.numRows; row++)
+	// cells far from fine particles are only solved when coarse particles are stepped
+	const int firstRow = coarseStep ? 0 : activeCells.top;
+	const int lastRow = coarseStep ? grid.numRows : activeCells.top + activeCells.height;
+	const int firstCol = coarseStep ? 0 : activeCells.left;
+	const int lastCol = coarseStep ? grid.numCols : activeCells.left + activeCells.width;
+	for (int row = firstRow; row < lastRow; row++)
 	{
-		for (int col = 0; col < grid.numCols; col++)
+		for (int col = firstCol; col < lastCol; col++)
 		{
 			CollisionCell& currentCell = grid.getCell(row, col);
 			// check its neighbors
@@ -363,22 +1198,26 @@ void Solver::solveGridCollision()
 					}
 				}
 			}
+			solveCellLinkCollision(row, col);
 		}
 	}
 }
 
 void Solver::solveCellCollision(CollisionCell& cell1, CollisionCell& cell2)
 {
+	// a particle is not tested against itself
+	stats.numPairTests += cell1.numObjects * cell2.numObjects - (&cell1 == &cell2 ? cell1.numObjects : 0);
+	Particle* data = particles.data();
 	for (int i = 0; i < cell1.numObjects; i++)
 	{
-		Particle* p1 = cell1.objects[i];
+		const civ::ID id1 = cell1.objects[i];
 		for (int j = 0; j < cell2.numObjects; j++)
 		{
-			Particle* p2 = cell2.objects[j];
+			const civ::ID id2 = cell2.objects[j];
 
-			if (p1->id != p2->id)
+			if (id1 != id2)
 			{
-				solveParticleCollision(p1, p2);
+				solveParticleCollision(&data[id1], &data[id2]);
 			}
 		}
 	}
@@ -392,19 +1231,131 @@ void Solver::solveParticleCollision(Particle* p1, Particle* p2)
 	sf::Vector2f direction = p1->currentPosition - p2->currentPosition;
 	float distance = Math::getLength(direction);
 	// the min distance to not overlap is the sum of radius
-	const float minDistance = p1->radius + p2->radius;
+	const float minDistance = getRadius(*p1) + getRadius(*p2);
 
-	if (distance < minDistance)
+	if (distance < minDistance && distance > 0.0f)
 	{
+		stats.numContacts++;
 		sf::Vector2f unit = direction / distance;
 
 		// distance to push to separate two particles
 		// minDistance - distance = overlappinig distance between two particles
 		// times 0.5 because each particles only need to move away half of that distance
 		float delta = responseCoef * 0.5f * (minDistance - distance);
-		p1->move(unit * delta);
-		p2->move(-unit * delta);
+		applyCollisionDelta(p1, unit * delta);
+		applyCollisionDelta(p2, -unit * delta);
+	}
+}
+
+void Solver::solveCellLinkCollision(int row, int col)
+{
+	CollisionCell& cell = grid.getCell(row, col);
+	Particle* data = particles.data();
+	Constraint* links = constraints.data();
+	for (int i = 0; i < cell.numObjects; i++)
+	{
+		Particle* particle = &data[cell.objects[i]];
+		// a link is inserted into every cell it passes through, so it can be found in several neighbors
+		const uint32_t stamp = ++linkStamp;
+		for (int r = std::max(row - 1, 0); r <= std::min(row + 1, grid.numRows - 1); r++)
+		{
+			for (int c = std::max(col - 1, 0); c <= std::min(col + 1, grid.numCols - 1); c++)
+			{
+				CollisionCell& neighborCell = grid.getCell(r, c);
+				for (int j = 0; j < neighborCell.numLinks; j++)
+				{
+					const civ::ID link = neighborCell.links[j];
+					if (linkStamps[link] == stamp)
+						continue;
+					linkStamps[link] = stamp;
+					stats.numLinkTests++;
+					solveParticleLinkCollision(particle, &links[link]);
+				}
+			}
+		}
+	}
+}
+
+void Solver::solveParticleLinkCollision(Particle* particle, Constraint* link)
+{
+	// strength of bouncing response when colliding
+	constexpr float responseCoef = 1.0f;
+
+	Particle* p1 = &(*link->p1);
+	Particle* p2 = &(*link->p2);
+	// a particle doesn't collide with its own link
+	if (particle == p1 || particle == p2)
+		return;
+
+	// find the closest point on the link to the particle
+	const sf::Vector2f segment = p2->currentPosition - p1->currentPosition;
+	const float segmentLength2 = segment.x * segment.x + segment.y * segment.y;
+	if (segmentLength2 == 0.0f)
+		return;
+	const sf::Vector2f toParticle = particle->currentPosition - p1->currentPosition;
+	const float t = (toParticle.x * segment.x + toParticle.y * segment.y) / segmentLength2;
+	// the two ends are already handled by particle-particle collision
+	if (t <= 0.0f || t >= 1.0f)
+		return;
+
+	const sf::Vector2f closest = p1->currentPosition + t * segment;
+	sf::Vector2f direction = particle->currentPosition - closest;
+	float distance = Math::getLength(direction);
+	// the capsule is as thick as its ends, interpolated along the link
+	const float minDistance = getRadius(*particle) + (1.0f - t) * getRadius(*p1) + t * getRadius(*p2);
+
+	if (distance < minDistance && distance > 0.0f)
+	{
+		sf::Vector2f unit = direction / distance;
+
+		// half of the overlapping goes to the particle, the other half is shared by
+		// the two ends of the link depending on where the contact is
+		float delta = responseCoef * 0.5f * (minDistance - distance);
+		// scaled so that the contact point itself (not only the ends) moves by delta
+		const float scale = delta / ((1.0f - t) * (1.0f - t) + t * t);
+		applyCollisionDelta(particle, unit * delta);
+		applyCollisionDelta(p1, -unit * scale * (1.0f - t));
+		applyCollisionDelta(p2, -unit * scale * t);
+	}
+}
+
+void Solver::applyCollisionDelta(Particle* particle, const sf::Vector2f& delta)
+{
+	if (collisionMode == CollisionMode::GaussSeidel)
+	{
+		particle->move(delta);
+		return;
 	}
+
+	// particles are stored contiguously, so the pointer gives its data index
+	const size_t index = particle - particles.data();
+	collisionDeltas[index] += delta;
+	collisionCounts[index]++;
+}
+
+void Solver::applyCollisionDeltas()
+{
+	std::vector<Particle>& data = particles.getData();
+	const size_t numParticles = data.size();
+	for (size_t i = 0; i < numParticles; i++)
+	{
+		// average the corrections so that crowded particles don't overshoot
+		if (collisionCounts[i] > 0 && !data[i].pinned)
+			data[i].currentPosition += collisionDeltas[i] / (float)collisionCounts[i];
+		// ready for the next collision iteration
+		collisionDeltas[i] = { 0.0f, 0.0f };
+		collisionCounts[i] = 0;
+	}
+}
+
+void Solver::setCollisionMode(CollisionMode mode)
+{
+	collisionMode = mode;
+}
+
+CollisionMode Solver::getCollisionMode()
+{
+	return collisionMode;
 }
 
 const float Solver::getElapsedTime()
@@ -419,9 +1370,41 @@ void Solver::setFrameDt(const int framerate)
 
 void Solver::setSubSteps(const int subSteps)
 {
+	const float previousStepDt = stepDt;
 	numSubSteps = subSteps;
 	// calculate time for each sub-step
 	stepDt = frameDt / (float)numSubSteps;
+
+	// the displacement of Verlet integration is the velocity times the step,
+	// so it is rescaled to keep velocities when the sub-steps change at runtime
+	if (previousStepDt > 0.0f && previousStepDt != stepDt)
+	{
+		const float scale = stepDt / previousStepDt;
+		for (Particle& particle : particles)
+		{
+			particle.prevPosition = particle.currentPosition - (particle.currentPosition - particle.prevPosition) * scale;
+		}
+	}
+}
+
+const int Solver::getSubSteps()
+{
+	return numSubSteps;
+}
+
+void Solver::setConstraintIterations(const int iterations)
+{
+	numConstraintIterations = iterations;
+}
+
+void Solver::setCollisionIterations(const int iterations)
+{
+	numCollisionIterations = iterations;
+}
+
+const int Solver::getCollisionIterations()
+{
+	return numCollisionIterations;
 }
 
 const float Solver::getStepDt()
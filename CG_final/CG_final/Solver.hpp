@@ -6,6 +6,27 @@
 #include "Constraint.hpp"
 #include "Wind.hpp"
 #include "CollisionGrid.hpp"
+#include "Batch.hpp"
+#include "Arena.hpp"
+#include "Prefab.hpp"
+#include "ShapeConstraint.hpp"
+#include "AreaConstraint.hpp"
+#include "RenderState.hpp"
+#include "Command.hpp"
+#include "SpscQueue.hpp"
+#include "SolverStats.hpp"
+
+// commands waiting for the next tick (input can't queue more in one frame)
+using CommandQueue = SpscQueue<Command, 1024>;
+
+// how collision corrections are applied
+enum class CollisionMode
+{
+	// move particles immediately (result depends on traversal order)
+	GaussSeidel,
+	// accumulate corrections and apply their average in one pass (order independent)
+	Jacobi
+};
 
 // this class is in charge of physics
 class Solver
@@ -15,24 +36,77 @@ public:
 
 	// functions for simulation
 	void update();
+	// input side, can be called from another thread than update (returns false if the queue is full)
+	// (pushing while update runs makes the frame a command lands on depend on timing, which breaks replays)
+	bool pushCommand(const Command& command);
+	// queue a strip, its points are copied (unlike pushCommand, this must not be called while update runs)
+	bool pushStrip(const sf::Vector2f* points, int count, bool pinEnds);
+	// commands are applied in the order they were pushed at the start of every update
+	void applyCommands();
+	void applyCommand(const Command& command);
+	// keep every applied command (stamped with its frame) so that a session can be replayed
+	void setRecording(bool record);
+	const std::vector<Command>& getRecordedCommands();
+	// points of the recorded strips, pointed to by their commands
+	const std::vector<sf::Vector2f>& getRecordedStripPoints();
 	void applyGravity();
 	void updateParticles(float dt);
 	void updateConstraints(float dt);
+	void sortParticles();
+	float computeLocalityCost();
+	void setSortInterval(const int frames);
+	// level of detail (particles outside of the active area are stepped every lodRatio sub-steps)
+	void updateLod();
+	void updateCoarseParticle(Particle& particle, float dt);
+	void setActiveArea(const sf::FloatRect& area);
+	void setLodRatio(const int ratio);
+	void setLodMargin(const float margin);
+	const int getNumCoarseParticles();
 
 	// creation and getters
 	civ::Ref<Particle> addParticle(const sf::Vector2f& position, bool pinned = false);
+	// the links, shapes and areas that use the particle are removed too
+	void removeParticle(civ::Ref<Particle> particle);
+	// drop the body storage of removed shapes and areas (the ranges of the others move to the front)
+	void compactBodies();
 	const civ::IndexVector<Particle>& getParticles();
 	const int getNumParticles();
+	// per-particle attributes (side arrays are only allocated once a value differs from the default)
+	float getRadius(const Particle& particle);
+	float getInverseMass(const Particle& particle);
+	void setRadius(civ::Ref<Particle> particle, float radius);
+	void setMass(civ::Ref<Particle> particle, float mass);
 
-	civ::Ref<Constraint> addConstraint(civ::Ref<Particle> p1, civ::Ref<Particle> p2, float distance = -1.0f, float strength = 1.0f);
+	civ::Ref<Constraint> addConstraint(civ::Ref<Particle> p1, civ::Ref<Particle> p2, float distance = -1.0f, float compliance = 0.0f, bool collidable = false);
 	const civ::IndexVector<Constraint>& getConstraints();
 	const int getNumLinks();
 
+	civ::Ref<ShapeConstraint> addShape(const civ::Ref<Particle>* particles, int count, float compliance = 0.0f);
+	const civ::IndexVector<ShapeConstraint>& getShapes();
+
+	civ::Ref<AreaConstraint> addArea(const civ::Ref<Particle>* ring, int count, float compliance = 0.0f, float pressure = 1.0f);
+	const civ::IndexVector<AreaConstraint>& getAreas();
+	// particles of the shapes and areas are in here (see their ranges)
+	const BodyStorage& getBodies();
+
+	// batch building (storage is reserved once and everything is committed in one step)
+	void reserve(int numParticles, int numConstraints);
+	Batch& beginBatch();
+	void commitBatch(Batch& batch);
+	// bulk insert a prefab rotated by angle (radians) at position, a negative compliance keeps the prefab's one
+	void addPrefab(const Prefab& prefab, const sf::Vector2f& position, float angle = 0.0f, bool pinned = false, float compliance = -1.0f);
+
 	civ::Ref<Wind> addWind(const sf::Vector2f& position, const sf::Vector2f& size, float speed, float strength);
 	const civ::IndexVector<Wind>& getWinds();
 
 	const sf::Vector3f getWorld();
+	const sf::Vector2f getGravity();
 	CollisionGrid& getGrid();
+	// copy what has to be drawn (so that rendering doesn't need the solver)
+	void writeRenderState(RenderState& state);
+	// split the links into chains (paths through particles with exactly two links) and single links,
+	// and group them into structures (links connected to each other)
+	void findLinkTopology();
 
 	// collision functions
 	void fillCollisionGrid();
@@ -40,6 +114,13 @@ public:
 	void solveGridCollision();
 	void solveCellCollision(CollisionCell& cell1, CollisionCell& cell2);
 	void solveParticleCollision(Particle* p1, Particle* p2);
+	// particles of a cell against the links of its neighborhood
+	void solveCellLinkCollision(int row, int col);
+	void solveParticleLinkCollision(Particle* particle, Constraint* link);
+	void applyCollisionDelta(Particle* particle, const sf::Vector2f& delta);
+	void applyCollisionDeltas();
+	void setCollisionMode(CollisionMode mode);
+	CollisionMode getCollisionMode();
 	void solveCollisionWithWorld(Particle& particle);
 
 	// additional physics effect functions
@@ -50,31 +131,114 @@ public:
 	bool isValidPosition(const sf::Vector2f& position);
 	civ::Ref<Particle> getClickedParticle(const sf::Vector2f& clickedPosition);
 	civ::Ref<Particle> getNearestParticle(const sf::Vector2f& position);
-	void addCube(const sf::Vector2f& position, float stiffness = 1.0f, bool pinned = false);
-	void addChain(civ::Ref<Particle> p1, civ::Ref<Particle> p2);
-	void addCircle(const sf::Vector2f& poisition, float radius, int numParticles, float stiffness = 1.0f, bool pinCenter = false, bool pinOuter = false);
+	void addCube(const sf::Vector2f& position, float compliance = 0.0f, bool pinned = false);
+	void addChain(civ::Ref<Particle> p1, civ::Ref<Particle> p2, bool solid = true);
+	// particles at the given positions linked one after another (committed in one batch)
+	void addStrip(const sf::Vector2f* positions, int count, bool pinEnds = false, bool solid = true);
+	void addCircle(const sf::Vector2f& poisition, float radius, int numParticles, float compliance = 0.0f, bool pinCenter = false, bool pinOuter = false);
 
 	// timing functions
 	const float getElapsedTime();
 	void setFrameDt(const int framerate);
 	void setSubSteps(const int subSteps);
+	const int getSubSteps();
+	void setConstraintIterations(const int iterations);
+	void setCollisionIterations(const int iterations);
+	const int getCollisionIterations();
 	const float getStepDt();
 
+	// counters and phase times of the last frame (also copied into the render state)
+	const SolverStats& getStats();
+
 
 private:
 	sf::Vector2f gravity{ 0.0f, 1000.0f };
 	civ::IndexVector<Particle> particles;
 	civ::IndexVector<Constraint> constraints;
+	civ::IndexVector<ShapeConstraint> shapes;
+	civ::IndexVector<AreaConstraint> areas;
+	BodyStorage bodies;
 	civ::IndexVector<Wind> winds;
+	// chains are only searched again when links were added or removed
+	bool linksChanged = true;
+	// particle ids of every chain, chain i is [chainStarts[i], chainStarts[i + 1])
+	std::vector<civ::ID> chainParticles;
+	std::vector<int> chainStarts;
+	// whether a link (by data index) is part of a chain
+	std::vector<uint8_t> chainLinks;
+	// links of every chain in order, chain i starts at chainStarts[i] - i
+	std::vector<int> chainLinkIndices;
+	// structure of every link and the running maximum of its absolute strain
+	std::vector<int> linkStructures;
+	std::vector<float> structureMaxStrains;
+	// cell of every particle or link when grouping them for the render state
+	std::vector<int> renderCells;
+	CommandQueue commands;
+	// points of the queued strips (cleared once the commands are applied)
+	std::vector<sf::Vector2f> stripPoints;
+	bool recording = false;
+	std::vector<Command> recordedCommands;
+	std::vector<sf::Vector2f> recordedStripPoints;
+	// reused batch of the construction helpers and scratch memory for temporaries
+	Batch buildBatch;
+	Arena scratch;
+	// prefabs of the construction helpers (the circle is rebuilt only when its parameters change)
+	Prefab cubePrefab;
+	Prefab circlePrefab;
+	float circleRadius = 0.0f;
+	int circleNumParticles = 0;
+	bool circlePinCenter = false;
+	bool circlePinOuter = false;
 	// world box
 	sf::Vector2f worldSize;
 	float particleRadius = 1.0f;
+	// optional side arrays indexed like the particles (empty when every particle uses the default)
+	std::vector<float> radii;
+	std::vector<float> inverseMasses;
 	// collision grid
 	CollisionGrid grid;
+	// number of particles the grid was filled with, its data indices are only valid until a particle is removed or sorted
+	// (0 when they may point to other particles, particles after it were added since and aren't in the grid)
+	size_t numGridParticles = 0;
+	CollisionMode collisionMode = CollisionMode::GaussSeidel;
+	// per-particle accumulated corrections and their counts (only used by Jacobi mode)
+	std::vector<sf::Vector2f> collisionDeltas;
+	std::vector<int> collisionCounts;
+	// last particle visit that solved each link, so that a link found in several neighbor cells is only solved once
+	std::vector<uint32_t> linkStamps;
+	uint32_t linkStamp = 0;
 	// timer
 	float elapsedTime = 0.0f;
+	uint32_t frame = 0;
 	float frameDt = 0.0f;
+	// particles are sorted along a Morton curve of their cells every sortInterval frames
+	// (0 disables it) or when neighbors in cells are too far apart in memory
+	int sortInterval = 120;
+	int framesSinceSort = 0;
+	float localityCost = 0.0f;
+	float maxLocalityCost = 64.0f;
+	std::vector<std::pair<uint32_t, uint32_t>> sortKeys;
+	std::vector<civ::ID> sortOrder;
+	std::vector<float> sortScratch;
+	// level of detail, the ratio has to divide the number of sub-steps (1 disables it)
+	sf::FloatRect activeArea;
+	float lodMargin = 50.0f;
+	int requestedLodRatio = 1;
+	int lodRatio = 1;
+	int numCoarseParticles = 0;
+	// whether coarse particles are stepped in the current sub-step
+	bool coarseStep = true;
+	// cells that contain fine particles or their neighbors
+	sf::IntRect activeCells;
 	// sub-steps (steps to do per frame) for more precise simulation
 	int numSubSteps = 1;
 	float stepDt = 0.0f;
+	// constraint solver iterations per sub-step (doesn't affect collision cost)
+	int numConstraintIterations = 1;
+	// collision solving passes per sub-step
+	int numCollisionIterations = 1;
+	// statistics of the current frame, phases are timed from the end of the previous one
+	SolverStats stats;
+	sf::Clock phaseClock;
+	void endPhase(SolverPhase phase);
 };
\ No newline at end of file
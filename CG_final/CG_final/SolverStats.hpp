@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+
+// parts of a solver frame that are timed separately
+enum class SolverPhase
+{
+	Commands,
+	// particle sorting and level of detail
+	Sort,
+	Grid,
+	Collisions,
+	// forces and integration of the particles
+	Particles,
+	Constraints,
+	// copy into the render state
+	Output,
+	Count
+};
+
+// counters of the last solver frame (for statistics)
+struct SolverStats
+{
+	static constexpr int NUM_PHASES = (int)SolverPhase::Count;
+
+	// time spent in every phase in seconds
+	float phaseTimes[NUM_PHASES] = {};
+	int numParticles = 0;
+	// particles stepped less often because they are outside of the active area
+	int numCoarseParticles = 0;
+	int numLinks = 0;
+	int numShapes = 0;
+	int numAreas = 0;
+	// particle pairs of neighboring cells that were tested and the ones that overlapped (over all sub-steps)
+	int numPairTests = 0;
+	int numContacts = 0;
+	// particle and link tests against capsules
+	int numLinkTests = 0;
+	// grid entries of particles and links that were lost because their cell was full (over all sub-steps),
+	// they don't collide in that step
+	int numDroppedObjects = 0;
+	int numDroppedLinks = 0;
+	// reserved memory of the objects, the collision grid and the scratch arena in bytes
+	size_t storageBytes = 0;
+	size_t gridBytes = 0;
+	size_t scratchBytes = 0;
+
+	static const char* getPhaseName(int phase)
+	{
+		static const char* names[NUM_PHASES] = { "commands", "sort", "grid", "collisions", "particles", "constraints", "output" };
+		return names[phase];
+	}
+
+	float getTotalTime() const
+	{
+		float total = 0.0f;
+		for (float time : phaseTimes)
+			total += time;
+		return total;
+	}
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
+public:
+	// producer side, returns false if the queue is full
+	bool push(const T& item)
+	{
+		const size_t back = tail.load(std::memory_order_relaxed);
+		if (back - head.load(std::memory_order_acquire) == Capacity)
+			return false;
+		items[back & (Capacity - 1)] = item;
+		// publish the item after it has been written
+		tail.store(back + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side, returns false if the queue is empty
+	bool pop(T& item)
+	{
+		const size_t front = head.load(std::memory_order_relaxed);
+		if (front == tail.load(std::memory_order_acquire))
+			return false;
+		item = items[front & (Capacity - 1)];
+		// free the slot after it has been read
+		head.store(front + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool empty()
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+	std::array<T, Capacity> items;
+	// indices only grow, the slot is the index modulo the capacity
+	// (both sides are on their own cache line so the threads don't fight over it)
+	alignas(64) std::atomic<size_t> head{ 0 };
+	alignas(64) std::atomic<size_t> tail{ 0 };
+};
@@ -88,4 +88,12 @@ const sf::Vector2f StateManager::getScreenMousePosition()
 const sf::Vector2f StateManager::getWorldMousePosition()
 {
 	return state.worldMousePosition;
+}
+
+const sf::FloatRect StateManager::getVisibleArea()
+{
+	// inverse transform of the two corners of the window
+	const sf::Vector2f topLeft = screenToWorldPosition({ 0.0f, 0.0f });
+	const sf::Vector2f bottomRight = screenToWorldPosition(2.0f * state.center);
+	return { topLeft, bottomRight - topLeft };
 }
\ No newline at end of file
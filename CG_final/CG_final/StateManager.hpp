@@ -49,6 +49,8 @@ public:
 	void updateMousePosition(const sf::Vector2f& newMousePosition);
 	const sf::Vector2f getScreenMousePosition();
 	const sf::Vector2f getWorldMousePosition();
+	// part of the world that is visible in the window
+	const sf::FloatRect getVisibleArea();
 
 private:
 	State state;
@@ -0,0 +1,230 @@
+#include "StatsOverlay.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+
+// 3x5 pixel font from ' ' to 'Z' (lowercase is drawn as uppercase), rows from the top with 3 bits each
+constexpr int NUM_GLYPHS = 'Z' - ' ' + 1;
+constexpr uint16_t GLYPHS[NUM_GLYPHS] = {
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x52a5, 0x0000, 0x0000,
+	0x1491, 0x4494, 0x0000, 0x05d0, 0x0014, 0x01c0, 0x0002, 0x12a4,
+	0x7b6f, 0x2c97, 0x73e7, 0x73cf, 0x5bc9, 0x79cf, 0x79ef, 0x7249,
+	0x7bef, 0x7bcf, 0x0410, 0x0000, 0x0000, 0x0e38, 0x0000, 0x0000,
+	0x0000, 0x2bed, 0x6bae, 0x3923, 0x6b6e, 0x79a7, 0x79a4, 0x396b,
+	0x5bed, 0x7497, 0x126a, 0x5bad, 0x4927, 0x5fed, 0x6b6d, 0x2b6a,
+	0x6ba4, 0x2b73, 0x6bad, 0x388e, 0x7492, 0x5b6f, 0x5b6a, 0x5bfd,
+	0x5aad, 0x5a92, 0x72a7
+};
+// layout in screen pixels
+constexpr float PIXEL = 2.0f;
+constexpr float ADVANCE = 4 * PIXEL;
+constexpr float LINE_HEIGHT = 7 * PIXEL;
+constexpr float MARGIN = 10.0f;
+constexpr float PADDING = 8.0f;
+constexpr float GRAPH_HEIGHT = 60.0f;
+constexpr float BAR_WIDTH = 3.0f;
+const sf::Color BACKGROUND_COLOR(0, 0, 0, 160);
+const sf::Color TEXT_COLOR(230, 230, 230);
+
+StatsOverlay::StatsOverlay(float targetFrameTime, int numSamples)
+	:targetFrameTime(targetFrameTime), samples(numSamples, 0.0f) {}
+
+void StatsOverlay::update(const SolverStats& solver, const GovernorStats& governor, float frameTime, float physicsTime, float renderTime)
+{
+	time += frameTime;
+	intervalTime += frameTime;
+	samples[nextSample] = frameTime;
+	nextSample = (nextSample + 1) % samples.size();
+
+	numFrames++;
+	frameTimes += frameTime;
+	maxFrameTime = std::max(maxFrameTime, frameTime);
+	physicsTimes += physicsTime;
+	renderTimes += renderTime;
+	for (int i = 0; i < SolverStats::NUM_PHASES; i++)
+		phaseTimes[i] += solver.phaseTimes[i];
+	pairTests += solver.numPairTests;
+	contacts += solver.numContacts;
+	linkTests += solver.numLinkTests;
+	droppedObjects += solver.numDroppedObjects;
+	droppedLinks += solver.numDroppedLinks;
+	this->governor = governor;
+	if (intervalTime < interval)
+		return;
+
+	// counts are taken from the last frame, times and tests are averaged
+	average = solver;
+	for (int i = 0; i < SolverStats::NUM_PHASES; i++)
+		average.phaseTimes[i] = phaseTimes[i] / numFrames;
+	average.numPairTests = (int)(pairTests / numFrames);
+	average.numContacts = (int)(contacts / numFrames);
+	average.numLinkTests = (int)(linkTests / numFrames);
+	// overflows are summed over the interval so that rare ones still show
+	average.numDroppedObjects = droppedObjects;
+	average.numDroppedLinks = droppedLinks;
+	fps = numFrames / intervalTime;
+	averageFrameTime = frameTimes / numFrames;
+	peakFrameTime = maxFrameTime;
+	averagePhysicsTime = physicsTimes / numFrames;
+	averageRenderTime = renderTimes / numFrames;
+	if (log.is_open())
+		writeRow();
+	if (visible)
+		buildText();
+
+	intervalTime = 0.0f;
+	numFrames = 0;
+	frameTimes = maxFrameTime = physicsTimes = renderTimes = 0.0f;
+	std::fill(std::begin(phaseTimes), std::end(phaseTimes), 0.0f);
+	pairTests = contacts = linkTests = 0.0;
+	droppedObjects = droppedLinks = 0;
+}
+
+void StatsOverlay::draw(RenderContext& context)
+{
+	if (!visible)
+		return;
+	if (numTextVertices == 0)
+		buildText();
+
+	// oldest frame on the left, bars are cut at twice the target frame time
+	vertices.resize(numTextVertices);
+	const sf::Vector2f origin(MARGIN + PADDING, MARGIN + 2 * PADDING + textSize.y);
+	const int numSamples = (int)samples.size();
+	for (int i = 0; i < numSamples; i++)
+	{
+		const float sample = samples[(nextSample + i) % numSamples];
+		const float height = std::min(sample / (2.0f * targetFrameTime), 1.0f) * GRAPH_HEIGHT;
+		const sf::Color color = sample <= targetFrameTime ? sf::Color(80, 200, 80) : sf::Color(220, 60, 60);
+		addQuad({ origin.x + i * BAR_WIDTH, origin.y + GRAPH_HEIGHT - height, BAR_WIDTH - 1.0f, height }, color);
+	}
+	addQuad({ origin.x, origin.y + 0.5f * GRAPH_HEIGHT, numSamples * BAR_WIDTH, 1.0f }, sf::Color(255, 255, 255, 120));
+	context.drawOnScreen(vertices.data(), vertices.size(), sf::Quads);
+}
+
+void StatsOverlay::setInterval(float seconds)
+{
+	interval = seconds;
+}
+
+bool StatsOverlay::startLog(const std::string& path)
+{
+	log.open(path);
+	if (!log)
+		return false;
+	log << "time,fps,frame_ms,max_frame_ms,physics_ms,render_ms";
+	for (int i = 0; i < SolverStats::NUM_PHASES; i++)
+		log << ',' << SolverStats::getPhaseName(i) << "_ms";
+	log << ",particles,coarse_particles,links,shapes,areas,pair_tests,contacts,link_tests,dropped_objects,dropped_links"
+		<< ",sub_steps,collision_iterations,spawn_scale,storage_bytes,grid_bytes,scratch_bytes\n";
+	return true;
+}
+
+void StatsOverlay::setVisible(bool visible)
+{
+	this->visible = visible;
+	if (visible)
+		buildText();
+}
+
+bool StatsOverlay::isVisible()
+{
+	return visible;
+}
+
+void StatsOverlay::writeRow()
+{
+	log << time << ',' << fps << ',' << averageFrameTime * 1000.0f << ',' << peakFrameTime * 1000.0f << ','
+		<< averagePhysicsTime * 1000.0f << ',' << averageRenderTime * 1000.0f;
+	for (int i = 0; i < SolverStats::NUM_PHASES; i++)
+		log << ',' << average.phaseTimes[i] * 1000.0f;
+	log << ',' << average.numParticles << ',' << average.numCoarseParticles << ',' << average.numLinks << ','
+		<< average.numShapes << ',' << average.numAreas << ',' << average.numPairTests << ',' << average.numContacts << ','
+		<< average.numLinkTests << ',' << average.numDroppedObjects << ',' << average.numDroppedLinks << ',' << governor.subSteps << ',' << governor.collisionIterations << ',' << governor.spawnScale << ','
+		<< average.storageBytes << ',' << average.gridBytes << ',' << average.scratchBytes << '\n';
+	// flushed so that the file can be followed while running
+	log.flush();
+}
+
+void StatsOverlay::buildText()
+{
+	std::string text;
+	char line[128];
+	std::snprintf(line, sizeof(line), "FPS %.0f  FRAME %.2f MS (MAX %.2f)\n", fps, averageFrameTime * 1000.0f, peakFrameTime * 1000.0f);
+	text += line;
+	std::snprintf(line, sizeof(line), "PHYSICS %.2f MS  RENDER %.2f MS\n", averagePhysicsTime * 1000.0f, averageRenderTime * 1000.0f);
+	text += line;
+	// solver phases, three per line
+	for (int i = 0; i < SolverStats::NUM_PHASES; i++)
+	{
+		std::snprintf(line, sizeof(line), "%s %.2f%s", SolverStats::getPhaseName(i), average.phaseTimes[i] * 1000.0f,
+			i % 3 == 2 || i + 1 == SolverStats::NUM_PHASES ? "\n" : "  ");
+		text += line;
+	}
+	std::snprintf(line, sizeof(line), "PARTICLES %d (COARSE %d)  LINKS %d\n", average.numParticles, average.numCoarseParticles, average.numLinks);
+	text += line;
+	std::snprintf(line, sizeof(line), "SHAPES %d  AREAS %d\n", average.numShapes, average.numAreas);
+	text += line;
+	std::snprintf(line, sizeof(line), "PAIRS %d  CONTACTS %d  LINK TESTS %d\n", average.numPairTests, average.numContacts, average.numLinkTests);
+	text += line;
+	std::snprintf(line, sizeof(line), "FULL CELLS DROPPED %d PARTICLES  %d LINKS\n", average.numDroppedObjects, average.numDroppedLinks);
+	text += line;
+	std::snprintf(line, sizeof(line), "SUB-STEPS %d  ITERATIONS %d  SPAWN %.0f%%\n", governor.subSteps, governor.collisionIterations, governor.spawnScale * 100.0f);
+	text += line;
+	const float megabyte = 1024.0f * 1024.0f;
+	std::snprintf(line, sizeof(line), "MEMORY %.2f MB (OBJECTS %.2f GRID %.2f SCRATCH %.2f)",
+		(average.storageBytes + average.gridBytes + average.scratchBytes) / megabyte,
+		average.storageBytes / megabyte, average.gridBytes / megabyte, average.scratchBytes / megabyte);
+	text += line;
+
+	int numLines = 1;
+	int numColumns = 0;
+	int column = 0;
+	for (char c : text)
+	{
+		column = c == '\n' ? 0 : column + 1;
+		numLines += c == '\n';
+		numColumns = std::max(numColumns, column);
+	}
+	textSize = { numColumns * ADVANCE, numLines * LINE_HEIGHT };
+
+	// background behind the text and the graph
+	vertices.clear();
+	const float width = std::max(textSize.x, samples.size() * BAR_WIDTH) + 2 * PADDING;
+	addQuad({ MARGIN, MARGIN, width, textSize.y + GRAPH_HEIGHT + 3 * PADDING }, BACKGROUND_COLOR);
+	addText(text, { MARGIN + PADDING, MARGIN + PADDING });
+	numTextVertices = vertices.size();
+}
+
+void StatsOverlay::addText(const std::string& text, sf::Vector2f position)
+{
+	sf::Vector2f cursor = position;
+	for (char c : text)
+	{
+		if (c == '\n')
+		{
+			cursor = { position.x, cursor.y + LINE_HEIGHT };
+			continue;
+		}
+		const int index = std::toupper((unsigned char)c) - ' ';
+		if (index >= 0 && index < NUM_GLYPHS)
+		{
+			// one quad per lit pixel
+			for (int bit = 0; bit < 15; bit++)
+			{
+				if (GLYPHS[index] & (1 << (14 - bit)))
+					addQuad({ cursor.x + (bit % 3) * PIXEL, cursor.y + (bit / 3) * PIXEL, PIXEL, PIXEL }, TEXT_COLOR);
+			}
+		}
+		cursor.x += ADVANCE;
+	}
+}
+
+void StatsOverlay::addQuad(const sf::FloatRect& rect, const sf::Color& color)
+{
+	vertices.emplace_back(sf::Vector2f(rect.left, rect.top), color);
+	vertices.emplace_back(sf::Vector2f(rect.left + rect.width, rect.top), color);
+	vertices.emplace_back(sf::Vector2f(rect.left + rect.width, rect.top + rect.height), color);
+	vertices.emplace_back(sf::Vector2f(rect.left, rect.top + rect.height), color);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include "RenderContext.hpp"
+#include "SolverStats.hpp"
+#include "Governor.hpp"
+
+// frame time, solver counters and memory drawn in the corner of the screen with a rolling frame time graph
+// (text and graph are quads of one vertex array, so the whole overlay is a single draw call)
+class StatsOverlay
+{
+public:
+	// the graph shows the last numSamples frames, the target frame time is at half of its height
+	StatsOverlay(float targetFrameTime, int numSamples = 120);
+
+	// measurements of one frame in seconds (frameTime is the whole main loop iteration)
+	void update(const SolverStats& solver, const GovernorStats& governor, float frameTime, float physicsTime, float renderTime);
+	void draw(RenderContext& context);
+
+	// the text and the rows of the log are averaged over this many seconds
+	void setInterval(float seconds);
+	// append a row of averages to a csv file every interval (also when the overlay is hidden)
+	bool startLog(const std::string& path);
+
+	void setVisible(bool visible);
+	bool isVisible();
+
+private:
+	void writeRow();
+	void buildText();
+	void addText(const std::string& text, sf::Vector2f position);
+	void addQuad(const sf::FloatRect& rect, const sf::Color& color);
+
+	float targetFrameTime;
+	float interval = 0.5f;
+	bool visible = false;
+	std::ofstream log;
+	// time since the overlay was created and since the last interval
+	float time = 0.0f;
+	float intervalTime = 0.0f;
+
+	// sums over the current interval
+	int numFrames = 0;
+	float frameTimes = 0.0f;
+	float maxFrameTime = 0.0f;
+	float physicsTimes = 0.0f;
+	float renderTimes = 0.0f;
+	float phaseTimes[SolverStats::NUM_PHASES] = {};
+	double pairTests = 0.0;
+	double contacts = 0.0;
+	double linkTests = 0.0;
+	int droppedObjects = 0;
+	int droppedLinks = 0;
+	// decisions of the governor in the last frame
+	GovernorStats governor;
+
+	// averages (and the peak frame time) of the last finished interval
+	SolverStats average;
+	float fps = 0.0f;
+	float averageFrameTime = 0.0f;
+	float peakFrameTime = 0.0f;
+	float averagePhysicsTime = 0.0f;
+	float averageRenderTime = 0.0f;
+
+	// ring buffer of the frame times of the graph
+	std::vector<float> samples;
+	int nextSample = 0;
+	// the text only changes every interval, the graph quads are appended after it every frame
+	std::vector<sf::Vertex> vertices;
+	size_t numTextVertices = 0;
+	sf::Vector2f textSize;
+};
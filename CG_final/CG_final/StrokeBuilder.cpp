@@ -0,0 +1,100 @@
+#include "StrokeBuilder.hpp"
+#include "Math.hpp"
+
+StrokeBuilder::StrokeBuilder(float spacing) : spacing(spacing)
+{
+	spline.setBezierInterpolation(true);
+	// segments are about one spacing long, so a few steps are enough to follow the curve
+	spline.setInterpolationSteps(4);
+	spline.setColor(sf::Color::Yellow);
+}
+
+void StrokeBuilder::begin(const sf::Vector2f& position)
+{
+	clear();
+	spline.addVertex(position);
+	spline.update();
+	active = true;
+}
+
+void StrokeBuilder::addSample(const sf::Vector2f& position)
+{
+	if (!active || Math::getDistance(position, spline.getPosition(spline.getLastVertexIndex())) < spacing)
+		return;
+	spline.addVertex(position);
+	// a new end vertex only bends the last few segments, so only those are rebuilt
+	const std::size_t count = spline.getVertexCount();
+	spline.smoothHandles(count >= 3 ? count - 3 : 0);
+	spline.update();
+}
+
+const std::vector<sf::Vector2f>& StrokeBuilder::finish(const sf::Vector2f& end)
+{
+	points.clear();
+	if (active)
+	{
+		// the release is usually closer than the spacing to the last sample, which addSample ignores
+		if (end != spline.getPosition(spline.getLastVertexIndex()))
+		{
+			spline.addVertex(end);
+			const std::size_t count = spline.getVertexCount();
+			spline.smoothHandles(count >= 3 ? count - 3 : 0);
+			spline.update();
+		}
+		resample(spline.exportAllInterpolatedPositions());
+	}
+	clear();
+	active = false;
+	return points;
+}
+
+bool StrokeBuilder::isActive()
+{
+	return active;
+}
+
+sw::Spline& StrokeBuilder::getSpline()
+{
+	return spline;
+}
+
+void StrokeBuilder::clear()
+{
+	// the spline throws when removing from an empty one
+	if (spline.getVertexCount() > 0)
+		spline.removeVertices(0);
+	spline.update();
+}
+
+void StrokeBuilder::resample(const std::vector<sf::Vector2f>& curve)
+{
+	if (curve.empty())
+		return;
+	points.push_back(curve[0]);
+	// distance already walked since the last point
+	float walked = 0.0f;
+	for (size_t i = 1; i < curve.size(); i++)
+	{
+		const sf::Vector2f start = curve[i - 1];
+		const sf::Vector2f direction = curve[i] - start;
+		const float length = Math::getLength(direction);
+		if (length <= 0.0f)
+			continue;
+		// a segment can hold more than one point
+		float offset = spacing - walked;
+		while (offset <= length)
+		{
+			points.push_back(start + direction * (offset / length));
+			offset += spacing;
+		}
+		walked = length - (offset - spacing);
+	}
+
+	// the ends get pinned, so the last point has to be where the stroke ended, a point closer than
+	// half a spacing is moved there instead of adding one that would overlap it
+	const sf::Vector2f& end = curve.back();
+	if (Math::getDistance(points.back(), end) >= 0.5f * spacing)
+		points.push_back(end);
+	else if (points.size() > 1)
+		points.back() = end;
+}
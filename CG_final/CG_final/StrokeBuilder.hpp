@@ -0,0 +1,33 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <SelbaWard/Spline.hpp>
+
+// turn a mouse stroke into evenly spaced points along a smooth curve (used to draw bridges)
+class StrokeBuilder
+{
+public:
+	// spacing is the distance between two points of the result (usually a particle diameter)
+	StrokeBuilder(float spacing);
+
+	void begin(const sf::Vector2f& position);
+	// samples closer than the spacing to the last one are ignored
+	void addSample(const sf::Vector2f& position);
+	// fit the samples and the end position with a Bezier spline, resample it and end the stroke
+	// (the result starts and ends exactly at the stroke and is valid until the next call)
+	const std::vector<sf::Vector2f>& finish(const sf::Vector2f& end);
+	bool isActive();
+
+	// preview of the current stroke
+	sw::Spline& getSpline();
+
+private:
+	void clear();
+	// walk along the interpolated curve and keep a point every spacing and the end of the curve
+	void resample(const std::vector<sf::Vector2f>& curve);
+
+	float spacing;
+	bool active = false;
+	sw::Spline spline;
+	std::vector<sf::Vector2f> points;
+};
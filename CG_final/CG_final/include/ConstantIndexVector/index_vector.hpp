@@ -1,11 +1,17 @@
 #pragma once
 #include <vector>
+#include <cstdint>
 
 
 namespace civ
 {
 
+// 32 bits ids keep Refs and index tables compact, define CIV_64BIT_ID if more are needed
+#ifdef CIV_64BIT_ID
 using ID = uint64_t;
+#else
+using ID = uint32_t;
+#endif
 
 /// Forward declaration
 template<typename TObjectType>
@@ -90,6 +96,23 @@ public:
         return id;
     }
 
+    /** Insert several objects at once
+     *
+     * @param objects The objects to copy
+     * @param count The number of objects
+     * @param ids If not null, receives the id of every inserted object
+     */
+    void push_back(const TObjectType* objects, size_t count, ID* ids = nullptr)
+    {
+        for (size_t i{0}; i < count; ++i) {
+            const ID id = getSlot();
+            m_data.push_back(objects[i]);
+            if (ids) {
+                ids[i] = id;
+            }
+        }
+    }
+
     template<typename... TArgs>
     ID emplace_back(TArgs&&... args)
     {
@@ -102,7 +125,7 @@ public:
     {
         // Fetch relevant info
         const ID data_id      = m_indexes[id];
-        const ID last_data_id = m_data.size() - 1;
+        const ID last_data_id = static_cast<ID>(m_data.size() - 1);
         const ID last_id      = m_metadata[last_data_id].rid;
         // Invalidate m_metadata
         m_metadata[data_id].validity_id = operation_count++;
@@ -122,7 +145,7 @@ public:
     ID getSlot()
     {
         const ID id = getSlotID();
-        m_indexes[id] = m_data.size();
+        m_indexes[id] = static_cast<ID>(m_data.size());
         return id;
     }
 
@@ -134,18 +157,24 @@ public:
             return m_metadata[m_data.size()].rid;
         }
         // A new slot has to be created
-        const ID new_id = m_data.size();
+        const ID new_id = static_cast<ID>(m_data.size());
         m_metadata.push_back({new_id, operation_count++});
         m_indexes.push_back(new_id);
         return new_id;
     }
 
     [[nodiscard]]
-    uint64_t getDataIndex(ID id) const
+    ID getDataIndex(ID id) const
     {
         return m_indexes[id];
     }
 
+    [[nodiscard]]
+    ID getIDAt(ID data_id) const
+    {
+        return m_metadata[data_id].rid;
+    }
+
     TObjectType& operator[](ID id)
     {
         return m_data[m_indexes[id]];
@@ -220,6 +249,35 @@ public:
     void reserve(size_t size)
     {
         m_data.reserve(size);
+        m_metadata.reserve(size);
+        m_indexes.reserve(size);
+    }
+
+    /** Reorder the objects in memory, IDs and references stay valid
+     *
+     * @param order order[i] is the current data index of the object to move at index i,
+     *              it has to be a permutation of [0, size())
+     */
+    void reorder(const std::vector<ID>& order)
+    {
+        m_reorder_data.clear();
+        m_reorder_metadata.clear();
+        m_reorder_data.reserve(m_data.capacity());
+        m_reorder_metadata.reserve(m_metadata.capacity());
+        for (const ID data_id : order) {
+            m_reorder_data.push_back(std::move(m_data[data_id]));
+            m_reorder_metadata.push_back(m_metadata[data_id]);
+        }
+        // Free slots stay after the objects
+        for (ID i = static_cast<ID>(m_data.size()); i < m_metadata.size(); ++i) {
+            m_reorder_metadata.push_back(m_metadata[i]);
+        }
+        std::swap(m_data, m_reorder_data);
+        std::swap(m_metadata, m_reorder_metadata);
+        // Update the ID -> data index mapping
+        for (ID i{0}; i < m_data.size(); ++i) {
+            m_indexes[m_metadata[i].rid] = i;
+        }
     }
 
     [[nodiscard]]
@@ -250,7 +308,7 @@ public:
         if (m_metadata.size() > m_data.size()) {
             return m_metadata[m_data.size()].rid;
         }
-        return m_data.size();;
+        return static_cast<ID>(m_data.size());
     }
 
 private:
@@ -263,8 +321,11 @@ private:
     std::vector<TObjectType> m_data;
     std::vector<Metadata>    m_metadata;
     std::vector<ID>          m_indexes;
+    // Scratch buffers kept to avoid allocations when reordering
+    std::vector<TObjectType> m_reorder_data;
+    std::vector<Metadata>    m_reorder_metadata;
 
-    uint64_t operation_count = 0;
+    ID operation_count = 0;
 };
 
 }
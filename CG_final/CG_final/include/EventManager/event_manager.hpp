@@ -1,8 +1,9 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
-#include <unordered_map>
 #include <functional>
+#include <vector>
+#include <array>
 
 namespace sfev
 {
@@ -10,21 +11,22 @@ namespace sfev
 // Helper using for shorter types
 using EventCallback = std::function<void(const sf::Event& event)>;
 
-template<typename T>
-using EventCallbackMap = std::unordered_map<T, EventCallback>;
-
 using CstEv = const sf::Event&;
 
 
 /*
     This class handles subtyped events like keyboard or mouse events
     The unpack function allows to get relevant information from the processed event
+    Callbacks are stored in a flat array indexed by the sub value (key code or button)
 */
 template<typename T>
 class SubTypeManager
 {
 public:
-    SubTypeManager(std::function<T(const sf::Event&)> unpack) :
+    using Unpack = T(*)(const sf::Event&);
+
+    SubTypeManager(Unpack unpack, size_t count) :
+        m_callbacks(count),
         m_unpack(unpack)
     {}
 
@@ -32,22 +34,28 @@ public:
 
     void processEvent(const sf::Event& event) const
     {
-        T sub_value = m_unpack(event);
-        auto it(m_callmap.find(sub_value));
-        if (it != m_callmap.end()) {
-            // Call its associated callback
-            (it->second)(event);
+        const int sub_value = static_cast<int>(m_unpack(event));
+        // Unknown keys are negative
+        if (sub_value >= 0 && sub_value < static_cast<int>(m_callbacks.size())) {
+            const EventCallback& callback = m_callbacks[sub_value];
+            if (callback) {
+                // Call its associated callback
+                callback(event);
+            }
         }
     }
 
     void addCallback(const T& sub_value, EventCallback callback)
     {
-        m_callmap[sub_value] = callback;
+        const int index = static_cast<int>(sub_value);
+        if (index >= 0 && index < static_cast<int>(m_callbacks.size())) {
+            m_callbacks[index] = callback;
+        }
     }
 
 private:
-    EventCallbackMap<T> m_callmap;
-    std::function<T(const sf::Event&)> m_unpack;
+    std::vector<EventCallback> m_callbacks;
+    Unpack m_unpack;
 };
 
 
@@ -55,10 +63,10 @@ class EventMap
 {
 public:
     EventMap(bool use_builtin_helpers = true)
-        : m_key_pressed_manager([](const sf::Event& event) {return event.key.code; })
-        , m_key_released_manager([](const sf::Event& event) {return event.key.code; })
-        , m_mouse_pressed_manager([](const sf::Event& event) {return event.mouseButton.button; })
-        , m_mouse_released_manager([](const sf::Event& event) {return event.mouseButton.button; })
+        : m_key_pressed_manager([](const sf::Event& event) {return event.key.code; }, sf::Keyboard::KeyCount)
+        , m_key_released_manager([](const sf::Event& event) {return event.key.code; }, sf::Keyboard::KeyCount)
+        , m_mouse_pressed_manager([](const sf::Event& event) {return event.mouseButton.button; }, sf::Mouse::ButtonCount)
+        , m_mouse_released_manager([](const sf::Event& event) {return event.mouseButton.button; }, sf::Mouse::ButtonCount)
     {
         if (use_builtin_helpers) {
             // Register key events built in callbacks
@@ -72,7 +80,7 @@ public:
     // Attaches new callback to an event
     void addEventCallback(sf::Event::EventType type, EventCallback callback)
     {
-        m_events_callmap[type] = callback;
+        m_events_callbacks[type] = callback;
     }
     
     // Adds a key pressed callback
@@ -102,10 +110,10 @@ public:
     // Runs the callback associated with an event
     void executeCallback(const sf::Event& e, EventCallback fallback = nullptr) const
     {
-        auto it(m_events_callmap.find(e.type));
-        if (it != m_events_callmap.end()) {
+        const EventCallback& callback = m_events_callbacks[e.type];
+        if (callback) {
             // Call its associated callback
-            (it->second)(e);
+            callback(e);
         } else if (fallback) {
             fallback(e);
         }
@@ -114,12 +122,8 @@ public:
     // Removes a callback
     void removeCallback(sf::Event::EventType type)
     {
-        // If event type is registred
-        auto it(m_events_callmap.find(type));
-        if (it != m_events_callmap.end()) {
-            // Remove its associated callback
-            m_events_callmap.erase(it);
-        }
+        // Remove its associated callback
+        m_events_callbacks[type] = nullptr;
     }
     
 private:
@@ -127,7 +131,8 @@ private:
     SubTypeManager<sf::Keyboard::Key> m_key_released_manager;
     SubTypeManager<sf::Mouse::Button> m_mouse_pressed_manager;
     SubTypeManager<sf::Mouse::Button> m_mouse_released_manager;
-    EventCallbackMap<sf::Event::EventType> m_events_callmap;
+    // Indexed by event type
+    std::array<EventCallback, sf::Event::Count> m_events_callbacks;
 };
 
 
@@ -145,13 +150,29 @@ public:
     }
 
     // Calls events' attached callbacks
+    // Consecutive mouse moves are merged, only the last one of a run is delivered
+    // (before the next other event, so that it still sees the right mouse position)
     void processEvents(EventCallback fallback = nullptr) const
     {
-        // Iterate over events
         sf::Event event;
+        sf::Event last_move;
+        bool has_move = false;
+        // Iterate over events
         while (m_window.pollEvent(event)) {
+            if (event.type == sf::Event::MouseMoved) {
+                last_move = event;
+                has_move = true;
+                continue;
+            }
+            if (has_move) {
+                m_event_map.executeCallback(last_move, fallback);
+                has_move = false;
+            }
             m_event_map.executeCallback(event, fallback);
         }
+        if (has_move) {
+            m_event_map.executeCallback(last_move, fallback);
+        }
     }
     
     // Attaches new callback to an event
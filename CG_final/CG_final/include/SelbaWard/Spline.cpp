@@ -37,6 +37,7 @@
 #include <random>
 #include <algorithm>
 #include <initializer_list>
+#include <limits>
 
 namespace
 {
@@ -53,18 +54,17 @@ const sf::PrimitiveType thickPrimitiveType{ sf::PrimitiveType::TrianglesStrip };
 const sf::PrimitiveType thickPrimitiveType{ sf::PrimitiveType::TriangleStrip };
 #endif // USE_SFML_PRE_2_4
 
-std::mt19937 randomGenerator;
-
-inline void randomSeed()
+// seeded on first use only (random_device is slow and most splines never use random offsets)
+inline std::mt19937& randomGenerator()
 {
-	std::random_device rd;
-	randomGenerator.seed(rd());
+	static std::mt19937 generator{ std::random_device{}() };
+	return generator;
 }
 
 inline float randomValue(const float range)
 {
 	assert(range > 0.f);
-	return std::uniform_real_distribution<float>{ 0.f, range }(randomGenerator);
+	return std::uniform_real_distribution<float>{ 0.f, range }(randomGenerator());
 }
 
 inline bool isSecondVectorClockwiseOfFirstVector(const sf::Vector2f& first, const sf::Vector2f& second)
@@ -191,8 +191,10 @@ Spline::Spline(const std::size_t vertexCount, const sf::Vector2f initialPosition
 	, m_showHandles{ false }
 	, m_lockHandleMirror{ true }
 	, m_lockHandleAngle{ true }
+	, m_isAllDirty{ true }
+	, m_dirtyFirst{ 0u }
+	, m_dirtyLast{ 0u }
 {
-	randomSeed();
 }
 
 Spline::Spline(std::initializer_list<sf::Vector2f> list)
@@ -229,6 +231,9 @@ Spline::Spline(const Spline& spline)
 	, m_showHandles{ spline.m_showHandles }
 	, m_lockHandleMirror{ spline.m_lockHandleMirror }
 	, m_lockHandleAngle{ spline.m_lockHandleAngle }
+	, m_isAllDirty{ spline.m_isAllDirty }
+	, m_dirtyFirst{ spline.m_dirtyFirst }
+	, m_dirtyLast{ spline.m_dirtyLast }
 {
 	m_vertices = spline.m_vertices;
 	m_interpolatedVertices = spline.m_interpolatedVertices;
@@ -262,6 +267,8 @@ Spline& Spline::operator=(const Spline& spline)
 	m_showHandles = spline.m_showHandles;
 	m_lockHandleMirror = spline.m_lockHandleMirror;
 	m_lockHandleAngle = spline.m_lockHandleAngle;
+	// interpolated vertices are not copied
+	priv_markAllDirty();
 
 	return *this;
 }
@@ -296,9 +303,15 @@ void Spline::update()
 		m_outputVertices.clear();
 		m_handlesVertices.clear();
 		m_interpolatedVerticesUnitTangents.clear();
+		m_isAllDirty = true;
 		return;
 	}
 
+	// closed splines and random offsets are always updated completely
+	const bool isFullUpdate{ m_isAllDirty || m_isClosed || m_isRandomNormalOffsetsActivated };
+	if (!isFullUpdate && m_dirtyFirst > m_dirtyLast)
+		return;
+
 	const std::size_t pointsPerVertex{ priv_getNumberOfPointsPerVertex() };
 	if (m_isClosed)
 		m_interpolatedVertices.resize((m_vertices.size() * pointsPerVertex) + 1);
@@ -307,10 +320,19 @@ void Spline::update()
 	m_interpolatedVerticesUnitTangents.resize(m_interpolatedVertices.size());
 
 	m_handlesVertices.resize((m_vertices.size()) * 4);
-	std::vector<sf::Vertex>::iterator itHandle{ m_handlesVertices.begin() };
 
-	for (std::vector<Vertex>::iterator begin{ m_vertices.begin() }, end{ m_vertices.end() }, last{ end - 1u }, it{ begin }; it != end; ++it)
+	// a control vertex changes the segments on both of its sides
+	std::size_t firstVertex{ 0u };
+	std::size_t lastVertex{ m_vertices.size() - 1u };
+	if (!isFullUpdate)
+	{
+		firstVertex = (m_dirtyFirst > 0u) ? m_dirtyFirst - 1u : 0u;
+		lastVertex = std::min(m_dirtyLast, lastVertex);
+	}
+
+	for (std::vector<Vertex>::iterator begin{ m_vertices.begin() }, end{ begin + lastVertex + 1u }, last{ m_vertices.end() - 1u }, it{ begin + firstVertex }; it != end; ++it)
 	{
+		std::vector<sf::Vertex>::iterator itHandle{ m_handlesVertices.begin() + (it - begin) * 4 };
 		itHandle->color = sf::Color(255, 255, 128, 32);
 		itHandle++->position = it->position;
 		itHandle->color = sf::Color(0, 255, 0, 128);
@@ -348,8 +370,13 @@ void Spline::update()
 		m_interpolatedVertices.back().color = m_color;
 	}
 
+	// tangents (and output vertices) also depend on the neighbours of the recomputed points
+	const std::size_t lastInterpolated{ m_interpolatedVertices.size() - 1u };
+	const std::size_t firstTangent{ (isFullUpdate || firstVertex == 0u) ? 0u : firstVertex * pointsPerVertex - 1u };
+	const std::size_t lastTangent{ isFullUpdate ? lastInterpolated : std::min((lastVertex + 1u) * pointsPerVertex, lastInterpolated) };
+
 	// calculate tangents
-	for (std::vector<sf::Vertex>::iterator begin{ m_interpolatedVertices.begin() }, end{ m_interpolatedVertices.end() }, last{ end - 1u }, current{ begin }; current != end; ++current)
+	for (std::vector<sf::Vertex>::iterator begin{ m_interpolatedVertices.begin() }, end{ begin + lastTangent + 1u }, last{ m_interpolatedVertices.end() - 1u }, current{ begin + firstTangent }; current != end; ++current)
 	{
 		std::vector<sf::Vertex>::iterator next{ current };
 		std::vector<sf::Vertex>::iterator previous{ current };
@@ -369,16 +396,19 @@ void Spline::update()
 		tangent = vectorUnit(previousVectorUnit + nextVectorUnit);
 	}
 
-	priv_updateOutputVertices();
+	priv_updateOutputVertices(firstTangent, lastTangent);
+	priv_clearDirty();
 }
 
 void Spline::updateOutputVertices()
 {
-	priv_updateOutputVertices();
+	if (!m_interpolatedVertices.empty())
+		priv_updateOutputVertices(0u, m_interpolatedVertices.size() - 1u);
 }
 
 void Spline::connectFrontToFrontOf(const Spline& spline, const bool rotateSpline, const bool moveSpline)
 {
+	priv_markAllDirty();
 	if (!moveSpline && !rotateSpline)
 		m_vertices.front().position = spline.getPosition(0u);
 	else
@@ -401,6 +431,7 @@ void Spline::connectFrontToFrontOf(const Spline& spline, const bool rotateSpline
 
 void Spline::connectFrontToBackOf(const Spline& spline, const bool rotateSpline, const bool moveSpline)
 {
+	priv_markAllDirty();
 	if (!moveSpline && !rotateSpline)
 		m_vertices.front().position = spline.getPosition(spline.getVertexCount() - 1u);
 	else
@@ -423,6 +454,7 @@ void Spline::connectFrontToBackOf(const Spline& spline, const bool rotateSpline,
 
 void Spline::connectBackToFrontOf(const Spline& spline, const bool rotateSpline, const bool moveSpline)
 {
+	priv_markAllDirty();
 	if (!moveSpline && !rotateSpline)
 		m_vertices.back().position = spline.getPosition(0u);
 	else
@@ -445,6 +477,7 @@ void Spline::connectBackToFrontOf(const Spline& spline, const bool rotateSpline,
 
 void Spline::connectBackToBackOf(const Spline& spline, const bool rotateSpline, const bool moveSpline)
 {
+	priv_markAllDirty();
 	if (!moveSpline && !rotateSpline)
 		m_vertices.back().position = spline.getPosition(spline.getVertexCount() - 1u);
 	else
@@ -507,6 +540,7 @@ void Spline::addSplineConnectBackToBack(Spline spline, const bool rotateSpline,
 
 void Spline::addSplineToFront(const Spline& spline)
 {
+	priv_markAllDirty();
 	addVertices(spline.getVertexCount(), 0u);
 	for (std::size_t i{ 0u }; i < spline.getVertexCount(); ++i)
 	{
@@ -521,6 +555,7 @@ void Spline::addSplineToFront(const Spline& spline)
 
 void Spline::addSplineToBack(const Spline& spline)
 {
+	priv_markAllDirty();
 	const std::size_t initialSize{ m_vertices.size() };
 	addVertices(spline.getVertexCount());
 	for (std::size_t i{ 0u }; i < spline.getVertexCount(); ++i)
@@ -537,6 +572,7 @@ void Spline::addSplineToBack(const Spline& spline)
 void Spline::setClosed(const bool isClosed)
 {
 	m_isClosed = isClosed;
+	priv_markAllDirty();
 }
 
 void Spline::rotate(const float angle, const sf::Vector2f origin)
@@ -549,6 +585,7 @@ void Spline::rotate(const float angle, const sf::Vector2f origin)
 		vertex.frontHandle = rotatePoint(vertex.frontHandle, c, s);
 		vertex.backHandle = rotatePoint(vertex.backHandle, c, s);
 	}
+	priv_markAllDirty();
 }
 
 void Spline::scale(const float scale, const sf::Vector2f origin, const bool scaleThickness, const bool scaleHandles)
@@ -564,52 +601,62 @@ void Spline::scale(const float scale, const sf::Vector2f origin, const bool scal
 	}
 	if (scaleThickness)
 		m_thickness *= scale;
+	priv_markAllDirty();
 }
 
 void Spline::move(const sf::Vector2f offset)
 {
 	for (auto& vertex : m_vertices)
 		vertex.position += offset;
+	priv_markAllDirty();
 }
 
 void Spline::setRandomNormalOffsetsActivated(const bool randomNormalOffsetsActivated)
 {
 	m_isRandomNormalOffsetsActivated = randomNormalOffsetsActivated;
+	priv_markAllDirty();
 }
 
 void Spline::setThickCornerType(const ThickCornerType thickCornerType)
 {
 	m_thickCornerType = thickCornerType;
+	priv_markAllDirty();
 }
 
 void Spline::setRoundedThickCornerInterpolationLevel(const std::size_t roundedThickCornerInterpolationLevel)
 {
 	m_roundedThickCornerInterpolationLevel = roundedThickCornerInterpolationLevel;
+	priv_markAllDirty();
 }
 
 void Spline::setThickStartCapType(const ThickCapType thickStartCapType)
 {
 	m_thickStartCapType = thickStartCapType;
+	priv_markAllDirty();
 }
 
 void Spline::setRoundedThickStartCapInterpolationLevel(const std::size_t roundedThickStartCapInterpolationLevel)
 {
 	m_roundedThickStartCapInterpolationLevel = roundedThickStartCapInterpolationLevel;
+	priv_markAllDirty();
 }
 
 void Spline::setThickEndCapType(const ThickCapType thickEndCapType)
 {
 	m_thickEndCapType = thickEndCapType;
+	priv_markAllDirty();
 }
 
 void Spline::setRoundedThickEndCapInterpolationLevel(const std::size_t roundedThickEndCapInterpolationLevel)
 {
 	m_roundedThickEndCapInterpolationLevel = roundedThickEndCapInterpolationLevel;
+	priv_markAllDirty();
 }
 
 void Spline::setMaxCornerPointLength(const float maxCornerPointLength)
 {
 	m_maxPointLength = maxCornerPointLength;
+	priv_markAllDirty();
 }
 
 void Spline::reserveVertices(const std::size_t numberOfVertices)
@@ -652,12 +699,17 @@ void Spline::addVertices(const std::size_t numberOfVertices, const std::size_t i
 void Spline::addVertex(const sf::Vector2f position)
 {
 	m_vertices.emplace_back(Vertex(position));
+	// the points before the previous last vertex don't move
+	priv_markDirty(m_vertices.size() - 1u, m_vertices.size() - 1u);
 }
 
 void Spline::addVertex(const std::size_t index, const sf::Vector2f position)
 {
 	if (index < getVertexCount())
+	{
 		m_vertices.insert(m_vertices.begin() + index, Vertex(position));
+		priv_markAllDirty();
+	}
 	else
 		addVertex(position);
 }
@@ -668,6 +720,7 @@ void Spline::removeVertex(const std::size_t index)
 		return;
 
 	m_vertices.erase(m_vertices.begin() + index);
+	priv_markAllDirty();
 }
 
 void Spline::removeVertices(const std::size_t index, const std::size_t numberOfVertices)
@@ -679,6 +732,7 @@ void Spline::removeVertices(const std::size_t index, const std::size_t numberOfV
 		m_vertices.erase(m_vertices.begin() + index, m_vertices.end());
 	else
 		m_vertices.erase(m_vertices.begin() + index, m_vertices.begin() + index + numberOfVertices);
+	priv_markAllDirty();
 }
 
 void Spline::reverseVertices()
@@ -693,6 +747,7 @@ void Spline::reverseVertices()
 		vertex.frontHandle = vertex.backHandle;
 		vertex.backHandle = tempHandle;
 	}
+	priv_markAllDirty();
 }
 
 void Spline::setPosition(const std::size_t index, const sf::Vector2f position)
@@ -701,6 +756,7 @@ void Spline::setPosition(const std::size_t index, const sf::Vector2f position)
 		return;
 
 	m_vertices[index].position = position;
+	priv_markDirty(index, index);
 }
 
 void Spline::setPositions(const std::size_t index, std::size_t numberOfVertices, const sf::Vector2f position)
@@ -713,6 +769,7 @@ void Spline::setPositions(const std::size_t index, std::size_t numberOfVertices,
 
 	for (std::size_t v{ 0u }; v < numberOfVertices; ++v)
 		m_vertices[index + v].position = position;
+	priv_markDirty(index, index + numberOfVertices - 1u);
 }
 
 void Spline::setPositions(const std::vector<sf::Vector2f>& positions, std::size_t index)
@@ -721,6 +778,7 @@ void Spline::setPositions(const std::vector<sf::Vector2f>& positions, std::size_
 	if ((numberOfVertices < 1) || (!priv_testVertexIndex(index, "Cannot set vertices' positions")) || ((numberOfVertices > 1) && (!priv_testVertexIndex(index + numberOfVertices - 1, "Cannot set vertices' positions"))))
 		return;
 
+	priv_markDirty(index, index + numberOfVertices - 1u);
 	for (auto& position : positions)
 	{
 		m_vertices[index].position = position;
@@ -746,6 +804,7 @@ void Spline::setFrontHandle(const std::size_t index, const sf::Vector2f offset)
 		m_vertices[index].backHandle = -offset;
 	else if (m_lockHandleAngle)
 		copyAngle(m_vertices[index].frontHandle, m_vertices[index].backHandle);
+	priv_markDirty(index, index);
 }
 
 sf::Vector2f Spline::getFrontHandle(const std::size_t index) const
@@ -766,6 +825,7 @@ void Spline::setBackHandle(const std::size_t index, const sf::Vector2f offset)
 		m_vertices[index].frontHandle = -offset;
 	else if (m_lockHandleAngle)
 		copyAngle(m_vertices[index].backHandle, m_vertices[index].frontHandle);
+	priv_markDirty(index, index);
 }
 
 sf::Vector2f Spline::getBackHandle(const std::size_t index) const
@@ -789,43 +849,36 @@ void Spline::resetHandles(const std::size_t index, std::size_t numberOfVertices)
 		m_vertices[index + v].frontHandle = { 0.f, 0.f };
 		m_vertices[index + v].backHandle = { 0.f, 0.f };
 	}
+	priv_markDirty(index, index + numberOfVertices - 1u);
 }
 
 void Spline::smoothHandles()
 {
 	for (std::size_t v{ 0 }; v < m_vertices.size() - 1; ++v)
-	{
-		const sf::Vector2f p1{ m_vertices[v].position };
-		const sf::Vector2f p2{ m_vertices[v + 1].position };
-		sf::Vector2f p0{ p1 };
-		sf::Vector2f p3{ p2 };
-		if (v > 0)
-			p0 = m_vertices[v - 1].position;
-		if (v < m_vertices.size() - 2)
-			p3 = m_vertices[v + 2].position;
-
-		const sf::Vector2f m0{ linearInterpolation(p0, p1, 0.5f) };
-		const sf::Vector2f m1{ linearInterpolation(p1, p2, 0.5f) };
-		const sf::Vector2f m2{ linearInterpolation(p2, p3, 0.5f) };
-
-		const float p01{ vectorLength(p1 - p0) };
-		const float p12{ vectorLength(p2 - p1) };
-		const float p23{ vectorLength(p3 - p2) };
-		float proportion0{ 0.f };
-		float proportion1{ 0.f };
-		if (p01 + p12 != 0.f)
-			proportion0 = p01 / (p01 + p12);
-		if (p12 + p23 != 0.f)
-			proportion1 = p12 / (p12 + p23);
-
-		const sf::Vector2f q0{ linearInterpolation(m0, m1, proportion0) };
-		const sf::Vector2f q1{ linearInterpolation(m1, m2, proportion1) };
-
-		m_vertices[v].frontHandle = m1 - q0;
-		m_vertices[v + 1].backHandle = m1 - q1;
-	}
+		priv_smoothHandle(v);
 	m_vertices.front().backHandle = { 0.f, 0.f };
 	m_vertices.back().frontHandle = { 0.f, 0.f };
+	priv_markAllDirty();
+}
+
+void Spline::smoothHandles(const std::size_t index, std::size_t numberOfVertices)
+{
+	if ((!priv_testVertexIndex(index, "Cannot smooth vertices' handles")) || ((numberOfVertices > 1) && (!priv_testVertexIndex(index + numberOfVertices - 1, "Cannot smooth vertices' handles"))))
+		return;
+
+	if (numberOfVertices == 0)
+		numberOfVertices = m_vertices.size() - index;
+
+	// the handles of a segment depend on the vertex before and the vertex after it
+	const std::size_t first{ (index > 0u) ? index - 1u : 0u };
+	const std::size_t last{ std::min(index + numberOfVertices, m_vertices.size() - 1u) };
+	for (std::size_t v{ first }; v < last; ++v)
+		priv_smoothHandle(v);
+	if (first == 0u)
+		m_vertices.front().backHandle = { 0.f, 0.f };
+	if (last == m_vertices.size() - 1u)
+		m_vertices.back().frontHandle = { 0.f, 0.f };
+	priv_markDirty(first, last);
 }
 
 void Spline::setHandlesVisible(const bool handlesVisible)
@@ -836,16 +889,19 @@ void Spline::setHandlesVisible(const bool handlesVisible)
 void Spline::setColor(const sf::Color color)
 {
 	m_color = color;
+	priv_markAllDirty();
 }
 
 void Spline::setColor(const std::size_t index, const sf::Color color)
 {
 	m_vertices[index].color = color;
+	priv_markDirty(index, index);
 }
 
 void Spline::setInterpolationSteps(const std::size_t interpolationSteps)
 {
 	m_interpolationSteps = interpolationSteps;
+	priv_markAllDirty();
 }
 
 void Spline::setHandleAngleLock(const bool handleAngleLock)
@@ -861,6 +917,7 @@ void Spline::setHandleMirrorLock(const bool handleMirrorLock)
 void Spline::setBezierInterpolation(const bool bezierInterpolation)
 {
 	m_useBezier = bezierInterpolation;
+	priv_markAllDirty();
 }
 
 void Spline::setPrimitiveType(const sf::PrimitiveType primitiveType)
@@ -994,12 +1051,62 @@ std::size_t Spline::priv_getInterpolatedIndex(const std::size_t interpolationOff
 	return interpolatedPositionIndex;
 }
 
-void Spline::priv_updateOutputVertices()
+void Spline::priv_smoothHandle(const std::size_t v)
+{
+	const sf::Vector2f p1{ m_vertices[v].position };
+	const sf::Vector2f p2{ m_vertices[v + 1].position };
+	sf::Vector2f p0{ p1 };
+	sf::Vector2f p3{ p2 };
+	if (v > 0)
+		p0 = m_vertices[v - 1].position;
+	if (v < m_vertices.size() - 2)
+		p3 = m_vertices[v + 2].position;
+
+	const sf::Vector2f m0{ linearInterpolation(p0, p1, 0.5f) };
+	const sf::Vector2f m1{ linearInterpolation(p1, p2, 0.5f) };
+	const sf::Vector2f m2{ linearInterpolation(p2, p3, 0.5f) };
+
+	const float p01{ vectorLength(p1 - p0) };
+	const float p12{ vectorLength(p2 - p1) };
+	const float p23{ vectorLength(p3 - p2) };
+	float proportion0{ 0.f };
+	float proportion1{ 0.f };
+	if (p01 + p12 != 0.f)
+		proportion0 = p01 / (p01 + p12);
+	if (p12 + p23 != 0.f)
+		proportion1 = p12 / (p12 + p23);
+
+	const sf::Vector2f q0{ linearInterpolation(m0, m1, proportion0) };
+	const sf::Vector2f q1{ linearInterpolation(m1, m2, proportion1) };
+
+	m_vertices[v].frontHandle = m1 - q0;
+	m_vertices[v + 1].backHandle = m1 - q1;
+}
+
+void Spline::priv_markDirty(const std::size_t first, const std::size_t last)
+{
+	m_dirtyFirst = std::min(m_dirtyFirst, first);
+	m_dirtyLast = std::max(m_dirtyLast, last);
+}
+
+void Spline::priv_markAllDirty()
+{
+	m_isAllDirty = true;
+}
+
+void Spline::priv_clearDirty()
+{
+	m_isAllDirty = false;
+	m_dirtyFirst = std::numeric_limits<std::size_t>::max();
+	m_dirtyLast = 0u;
+}
+
+void Spline::priv_updateOutputVertices(const std::size_t firstInterpolated, const std::size_t lastInterpolated)
 {
 	if (!priv_isThick())
 	{
 		m_outputVertices.resize(m_interpolatedVertices.size());
-		for (std::vector<sf::Vertex>::iterator begin{ m_interpolatedVertices.begin() }, end{ m_interpolatedVertices.end() }, last{ end - 1u }, it{ begin }; it != end; ++it)
+		for (std::vector<sf::Vertex>::iterator begin{ m_interpolatedVertices.begin() }, end{ begin + lastInterpolated + 1u }, last{ m_interpolatedVertices.end() - 1u }, it{ begin + firstInterpolated }; it != end; ++it)
 		{
 			const std::size_t outputIndex{ static_cast<std::size_t>(it - begin) };
 			const std::size_t index{ outputIndex / priv_getNumberOfPointsPerVertex() };
@@ -1076,8 +1183,14 @@ void Spline::priv_updateOutputVertices()
 			numberOfVerticesRequired = (m_interpolatedVertices.size() - 2u) * numberOfVerticesRequiredPerCorner + 4u; // 2 per end
 		m_outputVertices.resize(numberOfVerticesRequired + numberOfExtraVerticesForCaps);
 
-		std::vector<sf::Vertex>::iterator itThick{ m_outputVertices.begin() };
+		// every interpolated vertex writes a fixed number of output vertices, so a range can start anywhere
+		std::size_t numberOfStartCapVertices{ 0u };
 		if (!m_isClosed && (m_thickStartCapType == ThickCapType::Round))
+			numberOfStartCapVertices = (m_roundedThickStartCapInterpolationLevel + 1u) * 2u;
+		std::vector<sf::Vertex>::iterator itThick{ m_outputVertices.begin() };
+		if (firstInterpolated > 0u)
+			itThick += numberOfStartCapVertices + 2u + (firstInterpolated - 1u) * numberOfVerticesRequiredPerCorner;
+		if (firstInterpolated == 0u && !m_isClosed && (m_thickStartCapType == ThickCapType::Round))
 		{
 			std::vector<Vertex>::iterator vertex{ m_vertices.begin() };
 			const float thickness{ m_thickness * vertex->thickness };
@@ -1098,7 +1211,7 @@ void Spline::priv_updateOutputVertices()
 				itThick++->position = vertex->position;
 			}
 		}
-		for (std::vector<sf::Vertex>::const_iterator begin{ m_interpolatedVertices.begin() }, end{ m_interpolatedVertices.end() }, last{ end - 1u }, it{ begin }; it != end; ++it)
+		for (std::vector<sf::Vertex>::const_iterator begin{ m_interpolatedVertices.begin() }, end{ begin + lastInterpolated + 1u }, last{ m_interpolatedVertices.end() - 1u }, it{ begin + firstInterpolated }; it != end; ++it)
 		{
 			const std::size_t outputIndex{ static_cast<std::size_t>(it - begin) };
 			const std::size_t index{ outputIndex / priv_getNumberOfPointsPerVertex() };
@@ -1309,6 +1422,10 @@ void Spline::priv_updateOutputVertices()
 				break;
 			}
 		}
+		// the rest only depends on the ends
+		if (lastInterpolated + 1u < m_interpolatedVertices.size())
+			return;
+
 		if (m_isClosed)
 		{
 			// match starting vertices to match modified ending vertices (to remove overlap)
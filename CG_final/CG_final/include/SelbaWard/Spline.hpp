@@ -150,6 +150,7 @@ public:
 	void resetHandles(std::size_t index = 0u, std::size_t numberOfVertices = 0u); // if numberOfVertices is zero (the default), reset handles for all vertices from specified index until the end. if no index is specified, all handles are reset
 
 	void smoothHandles();
+	void smoothHandles(std::size_t index, std::size_t numberOfVertices = 0u); // smooths the handles of the segments starting at the specified vertices (and their neighbours). if numberOfVertices is zero (the default), until the end
 
 	void setHandlesVisible(bool handlesVisible = true);
 	bool getHandlesVisible() const;
@@ -231,19 +232,29 @@ private:
 	bool m_lockHandleMirror;
 	bool m_lockHandleAngle;
 
+	// control vertices changed since the last update (update only recomputes the segments around them)
+	bool m_isAllDirty;
+	std::size_t m_dirtyFirst;
+	std::size_t m_dirtyLast;
+
 	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const;
 	bool priv_isValidVertexIndex(std::size_t vertexIndex) const;
 	bool priv_testVertexIndex(std::size_t vertexIndex, const std::string& exceptionMessage) const;
 	bool priv_isThick() const;
 	std::size_t priv_getNumberOfPointsPerVertex() const;
 	std::size_t priv_getInterpolatedIndex(const std::size_t interpolationOffset, const std::size_t index) const;
-	void priv_updateOutputVertices();
+	void priv_updateOutputVertices(std::size_t firstInterpolated, std::size_t lastInterpolated);
+	void priv_smoothHandle(std::size_t vertexIndex);
+	void priv_markDirty(std::size_t first, std::size_t last);
+	void priv_markAllDirty();
+	void priv_clearDirty();
 };
 
 template <class T>
 inline void Spline::setThickness(const T thickness)
 {
 	m_thickness = static_cast<float>(thickness);
+	priv_markAllDirty();
 }
 
 inline float Spline::getThickness() const
@@ -255,6 +266,7 @@ template <class T>
 inline void Spline::setThickness(const std::size_t index, const T thickness)
 {
 	m_vertices[index].thickness = static_cast<float>(thickness);
+	priv_markDirty(index, index);
 }
 
 inline float Spline::getThickness(const std::size_t index) const
@@ -266,6 +278,7 @@ template<class T>
 inline void Spline::setRandomNormalOffsetRange(const T randomNormalOffsetRange)
 {
 	m_randomNormalOffsetRange = static_cast<float>(randomNormalOffsetRange);
+	priv_markAllDirty();
 }
 
 inline float Spline::getRandomNormalOffsetRange() const
@@ -277,6 +290,7 @@ template <class T>
 inline void Spline::setRandomNormalOffsetRange(const std::size_t index, const T randomNormalOffsetRange)
 {
 	m_vertices[index].randomNormalOffsetRange = static_cast<float>(randomNormalOffsetRange);
+	priv_markDirty(index, index);
 }
 
 inline float Spline::getRandomNormalOffsetRange(const std::size_t index) const
@@ -286,6 +300,8 @@ inline float Spline::getRandomNormalOffsetRange(const std::size_t index) const
 
 inline Spline::Vertex& Spline::operator[] (const std::size_t index)
 {
+	// the vertex can be changed in any way through the reference
+	priv_markAllDirty();
 	return m_vertices[index];
 }
 
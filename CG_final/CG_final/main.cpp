@@ -4,17 +4,30 @@
 #include "Renderer.hpp"
 #include "Random.hpp"
 #include "Math.hpp"
+#include "Governor.hpp"
+#include "PhysicsThread.hpp"
 #include <iostream>
-#include <SelbaWard/Spline.hpp>
+#include "StrokeBuilder.hpp"
+#include "StatsOverlay.hpp"
+#include <string>
+#include <cstdlib>
 
 
-int main()
+// options:
+// --headless <frames>  draw into a render texture instead of a window and stop after that many frames
+// --capture <output>   write every frame as numbered PNG files (frame%05d.png) or to a command after a '|'
+// --stats <file>       append averaged frame statistics to a csv file twice per second
+int main(int argc, char* argv[])
 {
 	// constants
 	const int WINDOW_WIDTH = 1920;
 	const int WINDOW_HEIGHT = 1080;
 	const int FRAMERATE = 60;
 	const int NUM_SUB_STEPS = 8;
+	const int MIN_SUB_STEPS = 2; // the governor keeps sub-steps and collision iterations in these bounds
+	const int MAX_COLLISION_ITERATIONS = 2;
+	const int NUM_CONSTRAINT_ITERATIONS = 1;
+	const int LOD_RATIO = 2; // particles outside of the view use NUM_SUB_STEPS / LOD_RATIO sub-steps
 	const int MAX_NUM_OBJECTS = 2000;
 	const float OBJECT_RADIUS = 5.0f;
 	const int CELL_SIZE = 2 * OBJECT_RADIUS;
@@ -28,16 +41,32 @@ int main()
 	// control varaibles
 	bool useForce = false; // apply force on objects
 	bool isBuilding = false; // build or not
-	int buildMode = 0; // 0: particle, 1: cube
+	int buildMode = 0; // 0: particle, 1: cube, 2: circle, 3: bridge
 	bool pinned = false; // pin objects or not
 	bool chaining = false; // chain the drawn particles together
 	bool showGrid = false; // show collision grid or not
 	bool useWind = false; // use wind or not
 	bool grabbing = false; // grab clicked object
 	bool pause = false; // pause game or not
+	int headlessFrames = 0; // number of frames to run without window (0 opens a window)
+	std::string captureOutput;
+	std::string statsOutput;
 
-	Game game(WINDOW_WIDTH, WINDOW_HEIGHT, "SFML Game", sf::Style::Default);
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const std::string option = argv[i];
+		if (option == "--headless")
+			headlessFrames = std::atoi(argv[i + 1]);
+		else if (option == "--capture")
+			captureOutput = argv[i + 1];
+		else if (option == "--stats")
+			statsOutput = argv[i + 1];
+	}
+
+	Game game(WINDOW_WIDTH, WINDOW_HEIGHT, "SFML Game", sf::Style::Default, headlessFrames > 0);
 	RenderContext& context = game.getRenderContext();
+	if (!captureOutput.empty())
+		game.startCapture(captureOutput);
 
 	// settings
 	game.setFramerate(FRAMERATE);
@@ -55,20 +84,41 @@ int main()
 
 	solver.setFrameDt(FRAMERATE);
 	solver.setSubSteps(NUM_SUB_STEPS);
+	solver.setConstraintIterations(NUM_CONSTRAINT_ITERATIONS);
+	solver.setLodRatio(LOD_RATIO);
+	// adapt the simulation to hold the framerate
+	Governor governor(1.0f / FRAMERATE, MIN_SUB_STEPS, NUM_SUB_STEPS, MAX_COLLISION_ITERATIONS);
+	governor.setOverlapped(true);
+	sf::Clock frameClock;
+	float renderTime = 0.0f;
+	// frame time, phase times, counts and memory (drawn when toggled)
+	StatsOverlay stats(1.0f / FRAMERATE);
+	if (!statsOutput.empty() && !stats.startLog(statsOutput))
+		std::cout << "can't write statistics to " << statsOutput << std::endl;
+	sf::Clock loopClock;
 
 	std::vector<civ::Ref<Particle>> chainedParitlces;
-	std::vector<civ::Ref<Particle>> connected(2);
+	// clicked positions of the pivots of a chain
+	std::vector<sf::Vector2f> connected;
 	int counter = 0;
-	civ::ID lastClicked = 0;
+	// drives the direction of the fountain
+	float fountainTime = 0.0f;
 
-	//sw::Spline spline(10);
-	//spline.setBezierInterpolation(true);
-	//spline.setInterpolationSteps(1);
-	//spline.smoothHandles();
+	// bridges are drawn with a stroke and built at once when the mouse is released
+	StrokeBuilder stroke(2 * OBJECT_RADIUS);
 
 	// winds (there can be multiple winds)
 	solver.addWind({ 0.0f, 0.0f }, { 100.0f, WORLD_SIZE.y }, 10.0f, 500.0f);
 
+	civ::Ref<Particle> p1 = solver.addParticle({ 150.0f, 150.0f }, true);
+	civ::Ref<Particle> p2 = solver.addParticle({ 350.0f, 150.0f }, true);
+	solver.addChain(p1, p2);
+
+	// from here on the solver belongs to the physics thread, changes are pushed as commands
+	PhysicsThread physics(solver);
+	// commands are staged until the next frame is started, and dropped then if the queue is full
+	auto push = [&](const Command& command) { physics.pushCommand(command); };
+
 	// add additional events
 	sfev::EventManager& eventManager = game.getEventManager();
 	eventManager.addMousePressedCallback(sf::Mouse::Left, [&](const sf::Event& event) {
@@ -77,33 +127,25 @@ int main()
 		isBuilding = true;
 		if (chaining)
 		{
-			civ::Ref<Particle> particle = solver.getClickedParticle(game.getWorldMousePosition());
-			if (particle)
-			{
-				// if already stored a particle and this one is a new particle
-				if (connected[0] && particle->id != lastClicked)
-				{
-					connected[1] = particle;
-				}
-				else
-				{
-					connected[0] = particle;
-					lastClicked = particle->id;
-				}
-			}
+			// the second click replaces the last one until the chain is built
+			if (connected.size() == 2)
+				connected.pop_back();
+			connected.push_back(game.getWorldMousePosition());
 		}
 		});
 	eventManager.addMouseReleasedCallback(sf::Mouse::Left, [&](const sf::Event& event) {
 		game.release();
 		game.undrag();
 		isBuilding = false;
+		// pinned bridges hang from both ends
+		if (stroke.isActive())
+			physics.pushStrip(stroke.finish(game.getWorldMousePosition()), pinned);
 
 		// build a chain using two selected particles as pivots
-		if (connected[0] && connected[1])
+		if (connected.size() == 2)
 		{
-			solver.addChain(connected[0], connected[1]);
-			connected[0] = civ::Ref<Particle>();
-			connected[1] = civ::Ref<Particle>();
+			push(Command::chain(connected[0], connected[1]));
+			connected.clear();
 		}
 		});
 	eventManager.addMousePressedCallback(sf::Mouse::Right, [&](const sf::Event& event) {
@@ -113,7 +155,7 @@ int main()
 		useForce = false;
 		});
 	eventManager.addMousePressedCallback(sf::Mouse::Middle, [&](const sf::Event& event) {
-		buildMode = (buildMode + 1) % 3;
+		buildMode = (buildMode + 1) % 4;
 		});
 	eventManager.addKeyPressedCallback(sf::Keyboard::C, [&](const sf::Event& event) {
 		chaining = !chaining;
@@ -133,102 +175,123 @@ int main()
 	eventManager.addKeyPressedCallback(sf::Keyboard::Space, [&](const sf::Event& event) {
 		pause = !pause;
 		});
-
-	civ::Ref<Particle> p1 = solver.addParticle({ 150.0f, 150.0f }, true);
-	civ::Ref<Particle> p2 = solver.addParticle({ 350.0f, 150.0f }, true);
-	solver.addChain(p1, p2);
+	eventManager.addKeyPressedCallback(sf::Keyboard::V, [&](const sf::Event& event) {
+		// colour particles by their speed
+		renderer.setParticleColor(renderer.getParticleColor() == ParticleColor::Plain ? ParticleColor::Speed : ParticleColor::Plain);
+		});
+	eventManager.addKeyPressedCallback(sf::Keyboard::T, [&](const sf::Event& event) {
+		// colour links by how much they are stretched or compressed
+		renderer.setShowStrain(!renderer.isShowingStrain());
+		});
+	eventManager.addKeyPressedCallback(sf::Keyboard::S, [&](const sf::Event& event) {
+		stats.setVisible(!stats.isVisible());
+		});
+	eventManager.addKeyPressedCallback(sf::Keyboard::J, [&](const sf::Event& event) {
+		push(Command::make(CommandType::ToggleCollisionMode));
+		});
+	eventManager.addKeyPressedCallback(sf::Keyboard::F, [&](const sf::Event& event) {
+		// fix or release the particle under the mouse
+		push(Command::make(CommandType::Pin, game.getWorldMousePosition()));
+		});
+	eventManager.addKeyPressedCallback(sf::Keyboard::R, [&](const sf::Event& event) {
+		push(Command::make(CommandType::Remove, game.getWorldMousePosition()));
+		});
 
 	while (game.isRunning())
 	{
 		game.handleEvents();
 
-		if (!pause && solver.getNumParticles() < MAX_NUM_OBJECTS
-			&& spawnTimer.getElapsedTime().asSeconds() >= PARTICLE_SPAWN_TIME)
+		if (!pause)
+			fountainTime += 1.0f / FRAMERATE;
+
+		// spawning slows down (or stops) when the governor can't hold the framerate anymore
+		// (the number of particles of the last finished frame is close enough for the limit)
+		if (!pause && physics.getRenderState().positions.size() < MAX_NUM_OBJECTS && governor.getSpawnScale() > 0.0f
+			&& spawnTimer.getElapsedTime().asSeconds() >= PARTICLE_SPAWN_TIME / governor.getSpawnScale())
 		{
 			spawnTimer.restart();
 			if (rng.sampleUniform() <= 0.98f)
 			{
-				civ::Ref<Particle> particle = solver.addParticle(SPAWN_LOCATION);
-				const float elapsedTime = solver.getElapsedTime();
-				const float angle = sin(elapsedTime) + Math::PI * 0.5f;
-				/*particle->initVelocity(OBJECT_SPPED * sf::Vector2f(1.0f, 0.0f), solver.getStepDt());*/
-				particle->initVelocity(OBJECT_SPPED * sf::Vector2f(cos(angle), sin(angle)), solver.getStepDt());
-
+				const float angle = sin(fountainTime) + Math::PI * 0.5f;
+				/*push(Command::spawnParticle(SPAWN_LOCATION, OBJECT_SPPED * sf::Vector2f(1.0f, 0.0f)));*/
+				push(Command::spawnParticle(SPAWN_LOCATION, OBJECT_SPPED * sf::Vector2f(cos(angle), sin(angle))));
 			}
 			else
 			{
-				solver.addCube(SPAWN_LOCATION);
+				push(Command::spawnCube(SPAWN_LOCATION));
 			}
 			/*if (chaining)
 				chainedParitlces.push_back(particle);*/
 		}
 
 		const sf::Vector2f mousePosition = game.getWorldMousePosition();
+		// the size of the grid never changes, so it can be read while the physics thread runs
 		const sf::Vector2f gridCoord = (sf::Vector2f)solver.getGrid().getGridCoordinate(mousePosition, OBJECT_RADIUS);
 		sf::Vector2f objectPosition(gridCoord.y * CELL_SIZE + OBJECT_RADIUS, gridCoord.x * CELL_SIZE + OBJECT_RADIUS);
-		if (!chaining && !grabbing && isBuilding && solver.isValidPosition(objectPosition))
+		if (!chaining && !grabbing && isBuilding)
 		{
 			if (buildMode == 0 && spawnTimer.getElapsedTime().asSeconds() >= PARTICLE_SPAWN_TIME)
 			{
 				spawnTimer.restart();
 				//sf::Vector2f distance = game.dragPosition - game.prevDragPosition;
 				//sf::Vector2f unit = distance / Math::getLength(distance);
-				civ::Ref<Particle> particle = solver.addParticle(objectPosition, pinned);
+				push(Command::spawnParticle(objectPosition, { 0.0f, 0.0f }, pinned, true));
 				//solver.addParticle(objectPosition + 10.f * unit, pinned);
-				//sf::Vector2f screenPosition = game.getScreenMousePosition();
-				//spline.removeVertex(0);
-				//spline.addVertex(screenPosition);
-				//civ::Ref<Particle> particle = solver.addParticle(game.screenToWorldPosition(screenPosition), pinned);
 				//if (chaining)
 				//	chainedParitlces.push_back(particle);
-				//std::vector<sf::Vector2f> positions = spline.exportAllInterpolatedPositions();
-				//for (int i = 0; i < positions.size(); i++)
-				//{
-				//	solver.addParticle(game.screenToWorldPosition(positions[i]), pinned);
-				//}
 			}
 			else if (buildMode == 1 && spawnTimer.getElapsedTime().asSeconds() >= CUBE_SPAWN_TIME)
 			{
 				spawnTimer.restart();
-				solver.addCube(mousePosition, 1.0f, pinned);
+				push(Command::spawnCube(mousePosition, pinned, true));
 			}
 			else if (buildMode == 2 && spawnTimer.getElapsedTime().asSeconds() >= CIRCLE_SPAWN_TIME)
 			{
 				spawnTimer.restart();
-				solver.addCircle(mousePosition, 50.0f, 4);
+				push(Command::spawnCircle(mousePosition, 50.0f, 4, true));
 			}
-		}
-
-		if (grabbing)
-		{
-			civ::Ref<Particle> grabbed = solver.getNearestParticle(mousePosition);
-			if (grabbed)
+			else if (buildMode == 3)
 			{
-				sf::Vector2f direction = mousePosition - grabbed->currentPosition;
-				float distance = Math::getLength(direction);
-				if (distance > 0.3f)
-				{
-					sf::Vector2f unit = direction / distance;
-					grabbed->move(unit);
-				}
+				if (!stroke.isActive())
+					stroke.begin(mousePosition);
+				else
+					stroke.addSample(mousePosition);
 			}
 		}
 
+		if (grabbing)
+			push(Command::make(CommandType::Grab, mousePosition));
+
 		if (useWind)
-			solver.applyWind();
+			push(Command::make(CommandType::Wind));
 
 		if (useForce)
-			solver.applyForce(150.0f, game.getWorldMousePosition());
+			push(Command::force(mousePosition, 150.0f));
 
+		// the physics thread is idle between wait and start, so the solver can be used directly
+		physics.wait();
 		if (!pause)
-			solver.update();
+			governor.update(solver, physics.getStepTime(), renderTime);
+		// the whole iteration including the wait for the framerate limit
+		stats.update(physics.getRenderState().stats, governor.getStats(), loopClock.restart().asSeconds(), physics.getStepTime(), renderTime);
+		solver.setActiveArea(context.stateManager.getVisibleArea());
+		// simulate the next frame while the last finished one is drawn
+		physics.start(pause);
 
-		//spline.update();
+		frameClock.restart();
 		game.clear();
-		renderer.render(context, game.getWorldMousePosition(), buildMode, showGrid);
-		//game.getWindow().draw(spline);
+		renderer.render(context, physics.getRenderState(), game.getWorldMousePosition(), buildMode, showGrid);
+		if (stroke.isActive())
+			context.draw(stroke.getSpline(), sf::RenderStates());
+		stats.draw(context);
+		renderTime = frameClock.getElapsedTime().asSeconds();
+		// display waits for the framerate limit, so it is not measured
 		game.display();
+		if (game.isHeadless() && --headlessFrames == 0)
+			game.close();
 	}
 
+	physics.wait();
+
 	return 0;
 }
\ No newline at end of file